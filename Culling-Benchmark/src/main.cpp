@@ -0,0 +1,134 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "../../Graphics-Engine/src/vulkan/CpuCuller.hpp"
+#include "../../Graphics-Engine/src/vulkan/Camera.hpp"
+#include "../../Graphics-Engine/src/utils/Logger.hpp"
+#include "../../Graphics-Engine/src/utils/assert.hpp"
+
+struct Options
+{
+	std::vector<uint32_t> objectCounts = { 10000, 100000, 1000000 };
+	double minimumMilliseconds = 200.0;
+	float extent = 500.0f;
+};
+
+void printUsage()
+{
+	LOG_INFO("usage: Culling-Benchmark [-n objects]... [-t milliseconds per kernel] [-e scene extent]");
+}
+
+Options parseOptions(int argc, char** argv)
+{
+	Options options;
+	bool customCounts = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-n" && hasValue)
+		{
+			if (!customCounts)
+				options.objectCounts.clear();
+			customCounts = true;
+			options.objectCounts.push_back(static_cast<uint32_t>(std::stoul(argv[++i])));
+		}
+		else if (arg == "-t" && hasValue)
+			options.minimumMilliseconds = std::stod(argv[++i]);
+		else if (arg == "-e" && hasValue)
+			options.extent = std::stof(argv[++i]);
+		else
+			assert(false, "unknown argument");
+	}
+
+	return options;
+}
+
+Vk::BoundingSpheres createSpheres(uint32_t count, float extent)
+{
+	std::mt19937 random(count);
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+
+	Vk::BoundingSpheres spheres;
+	spheres.reserve(count);
+	for (uint32_t i = 0; i < count; ++i)
+		spheres.add(glm::vec4(position(random), position(random), position(random), radius(random)));
+
+	return spheres;
+}
+
+//repeats the cull until minimumMilliseconds have passed so small counts are not lost in timer noise
+void benchmark(const Vk::CpuCuller& culler, const Vk::BoundingSpheres& spheres, const std::array<glm::vec4, 6>& planes,
+	double minimumMilliseconds, uint32_t& visibleCount)
+{
+	std::vector<uint32_t> visible;
+	visibleCount = culler.cull(planes, spheres, visible);
+
+	uint32_t iterations = 0;
+	double milliseconds = 0.0;
+	auto start = std::chrono::high_resolution_clock::now();
+	do
+	{
+		culler.cull(planes, spheres, visible);
+		++iterations;
+		milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	} while (milliseconds < minimumMilliseconds);
+
+	double perCull = milliseconds / iterations;
+	LOG_INFO(std::string(Vk::CpuCuller::getKernelName(culler.getKernel())) + ": " + STR(perCull) + " ms, " +
+		STR(static_cast<uint64_t>(spheres.size() / perCull)) + " objects/ms");
+}
+
+void run(const Options& options)
+{
+	//planes of a real camera, so the visible fraction looks like a real scene
+	const Vk::Camera camera(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 16.0f / 9.0f, glm::radians(60.0f), 0.1f, 300.0f);
+	const auto& planes = camera.getFrustumPlanes();
+	const std::array kernels = { Vk::CullKernel::Scalar, Vk::CullKernel::Sse, Vk::CullKernel::Avx2 };
+
+	for (uint32_t objectCount : options.objectCounts)
+	{
+		Vk::BoundingSpheres spheres = createSpheres(objectCount, options.extent);
+		LOG_INFO(STR(objectCount) + " objects");
+
+		uint32_t expectedVisible = 0;
+		for (auto kernel : kernels)
+		{
+			if (!Vk::CpuCuller::isKernelSupported(kernel))
+			{
+				LOG_WARNING(std::string(Vk::CpuCuller::getKernelName(kernel)) + " is not supported on this cpu");
+				continue;
+			}
+
+			uint32_t visibleCount = 0;
+			benchmark(Vk::CpuCuller(kernel), spheres, planes, options.minimumMilliseconds, visibleCount);
+
+			if (kernel == Vk::CullKernel::Scalar)
+				expectedVisible = visibleCount;
+			else if (visibleCount != expectedVisible)
+				LOG_ERROR(std::string(Vk::CpuCuller::getKernelName(kernel)) + " found " + STR(visibleCount) + " visible, scalar " + STR(expectedVisible));
+		}
+
+		LOG_INFO(STR(expectedVisible) + " visible");
+		LOG_NEW_LINE();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		run(parseOptions(argc, argv));
+	}
+	catch (const std::exception& exception)
+	{
+		LOG_CRITICAL(exception.what());
+		printUsage();
+		return 1;
+	}
+
+	return 0;
+}
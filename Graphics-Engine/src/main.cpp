@@ -18,7 +18,11 @@
 #include "vulkan/Camera.hpp"
 #include "input/KeyboardMouse.hpp"
 #include "vulkan/Cube.hpp"
-#include "utils/path.hpp"
+
+//set by the visual studio project, other builds can define it on the command line
+#ifndef PROJECT_DIR
+#define PROJECT_DIR "."
+#endif
 
 void run()
 {
@@ -40,8 +44,12 @@ void run()
 	Vk::Renderer renderer(window, device, swapChain, pipeline, 2);
 	Vk::Camera camera({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, window.getAspectRatio(), glm::radians(50.0));
 	KeyboardMouse controlls(.5, .5);
+#ifndef NDEBUG
+	renderer.enableShaderReload((std::filesystem::path(PROJECT_DIR) / "src" / "shaders").string());
+#endif
+	bool gpuReportKeyDown = false;
 
-	//auto cube = std::make_shared<Vk::Cube>(Vk::Cube::createCube(device, glm::vec3{ 0.5, .5, .5 }, glm::vec3{ .0f, 0 , 1.5 }, glm::vec3{ 0 }, renderer.getCommandPool()));
+	//auto cube = std::make_shared<Vk::Cube>(Vk::Cube::createCube(device, glm::vec3{ 0.5, .5, .5 }, glm::vec3{ .0f, 0 , 1.5 }, glm::vec3{ 0 }));
 	//renderer.addRenderObject(cube);
 
 	while (!window.shouldClose())
@@ -52,6 +60,15 @@ void run()
 		{
 			renderer.drawFrame(camera);
 
+			//p logs the gpu time of every profiled pass once per press
+			const bool gpuReportKey = glfwGetKey(window.getWindowPtr(), GLFW_KEY_P) == GLFW_PRESS;
+			if (gpuReportKey && !gpuReportKeyDown)
+			{
+				for (const auto& scope : renderer.getGpuStats())
+					LOG_INFO("gpu " + scope.name + " avg " + STR(scope.average) + " ms, p95 " + STR(scope.percentile95) + " ms, p99 " + STR(scope.percentile99) + " ms");
+			}
+			gpuReportKeyDown = gpuReportKey;
+
 			auto change = controlls.getUpdate(window.getWindowPtr(), 0.006, camera.position.y);
 			if (change.has_value() )
 			{
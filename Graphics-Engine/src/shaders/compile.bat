@@ -1,2 +1,31 @@
-C:\VulkanSDK\1.3.204.0\Bin\glslc.exe shader.vert -o vert.spv
-C:\VulkanSDK\1.3.204.0\Bin\glslc.exe shader.frag -o frag.spv
\ No newline at end of file
+@echo off
+rem compiles and optimizes every shader and embeds them into EmbeddedShaders.hpp, the pre-build event runs this too
+rem usage: compile.bat [directory of Shader-Embedder.exe], without it the first built configuration found is used
+setlocal
+cd /d "%~dp0"
+
+if not defined VULKAN_SDK set "VULKAN_SDK=C:\VulkanSDK\1.3.204.0"
+
+set "embedder="
+if not "%~1"=="" set "embedder=%~1\Shader-Embedder.exe"
+if not defined embedder for %%c in (x64-Debug x64-Release Win32-Debug Win32-Release) do (
+	if not defined embedder if exist "..\..\..\build\%%c\Shader-Embedder.exe" set "embedder=..\..\..\build\%%c\Shader-Embedder.exe"
+)
+if not exist "%embedder%" (
+	echo cant find Shader-Embedder.exe, build it first or pass the directory it is in
+	exit /b 1
+)
+
+call :compile shader.vert vert.spv || exit /b 1
+call :compile shader.frag frag.spv || exit /b 1
+call :compile cull.comp cull.spv || exit /b 1
+call :compile pyramid.comp pyramid.spv || exit /b 1
+
+"%embedder%" -o EmbeddedShaders.hpp vert.spv frag.spv cull.spv pyramid.spv || exit /b 1
+exit /b 0
+
+rem a failed compile stops the build so a stale .spv never gets embedded
+:compile
+"%VULKAN_SDK%\Bin\glslc.exe" %1 -o %2 || exit /b 1
+"%VULKAN_SDK%\Bin\spirv-opt.exe" -O %2 -o %2 || exit /b 1
+exit /b 0
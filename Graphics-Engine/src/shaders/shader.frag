@@ -1,13 +1,64 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+//set per pipeline, branches on them are resolved when the pipeline is created
+layout(constant_id = 0) const bool texturing = true;
+layout(constant_id = 1) const bool vertexColor = false;
+layout(constant_id = 2) const uint lightingModel = 0;
+
+const uint unlit = 0;
+const uint lambert = 1;
+const uint blinnPhong = 2;
+
+const vec3 lightDirection = vec3(0.4, 0.8, 0.45);
+const float ambient = 0.15;
+const float shininess = 32.0;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragCord;
+layout(location = 2) flat in uint fragTextureIndex;
+layout(location = 3) in vec3 fragPosition;
 
-layout(binding = 1) uniform sampler2D texSampler;
+layout(binding = 1) uniform sampler2D textures[];
+
+layout(set = 1, binding = 1) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+} frame;
 
 layout(location = 0) out vec4 outColor;
 
+vec3 light(vec3 albedo)
+{
+    //there are no vertex normals, faces are lit flat and from both sides
+    vec3 normal = normalize(cross(dFdx(fragPosition), dFdy(fragPosition)));
+    vec3 toCamera = normalize(frame.cameraPosition.xyz - fragPosition);
+    if (dot(normal, toCamera) < 0.0)
+        normal = -normal;
+
+    vec3 toLight = normalize(lightDirection);
+    vec3 lit = albedo * (ambient + max(dot(normal, toLight), 0.0));
+    if (lightingModel == blinnPhong)
+    {
+        vec3 halfway = normalize(toLight + toCamera);
+        lit += vec3(pow(max(dot(normal, halfway), 0.0), shininess));
+    }
+
+    return lit;
+}
+
 void main() 
 {
-    outColor = texture(texSampler, fragCord);
+    vec4 color = vec4(1.0);
+    if (texturing)
+        color = texture(textures[nonuniformEXT(fragTextureIndex)], fragCord);
+    if (vertexColor)
+        color.rgb *= fragColor;
+    if (lightingModel != unlit)
+        color.rgb = light(color.rgb);
+
+    outColor = color;
 }
\ No newline at end of file
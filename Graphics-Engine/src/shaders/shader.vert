@@ -6,16 +6,36 @@ layout(location = 2) in vec2 texCord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragCord;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) out vec3 fragPosition;
 
-layout(push_constant) uniform Push
+struct Instance
 {
-    mat4 model;
+    mat3x4 model;
+    uint textureIndex;
+};
+
+layout(set = 1, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(set = 1, binding = 1) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
     mat4 viewProjection;
-} push;
+    vec4 cameraPosition;
+} frame;
 
 void main() 
 {
-    gl_Position = push.viewProjection * push.model * vec4(position, 1.0);
+    Instance instance = instances[gl_InstanceIndex];
+
+    vec3 worldPosition = vec4(position, 1.0) * instance.model;
+    gl_Position = frame.viewProjection * vec4(worldPosition, 1.0);
     fragColor = inColor;
     fragCord = texCord;
+    fragTextureIndex = instance.textureIndex;
+    fragPosition = worldPosition;
 }
\ No newline at end of file
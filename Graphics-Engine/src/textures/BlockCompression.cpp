@@ -0,0 +1,546 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include "BlockCompression.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BLOCK_COMPRESSION_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//pixels of one block split per channel, 0-255 range
+	struct Block
+	{
+		alignas(16) float channels[4][16];
+	};
+
+	struct BitWriter
+	{
+		uint8_t* data;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; ++i, ++position)
+				data[position / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (position % 8));
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t* data;
+		uint32_t position = 0;
+
+		uint32_t read(uint32_t count)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < count; ++i, ++position)
+				value |= ((data[position / 8] >> (position % 8)) & 1u) << i;
+			return value;
+		}
+	};
+
+	constexpr uint32_t bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	Block loadBlock(const uint8_t* rgba)
+	{
+		Block block;
+		for (size_t i = 0; i < 16; ++i)
+			for (size_t c = 0; c < 4; ++c)
+				block.channels[c][i] = rgba[i * 4 + c];
+		return block;
+	}
+
+	//endpoints along the principal axis of the block colors
+	void findEndpoints(const Block& block, uint32_t channelCount, float* start, float* end)
+	{
+		float mean[4] = {};
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			for (size_t i = 0; i < 16; ++i)
+				mean[c] += block.channels[c][i];
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (size_t i = 0; i < 16; ++i)
+			for (uint32_t a = 0; a < channelCount; ++a)
+				for (uint32_t b = a; b < channelCount; ++b)
+					covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+		for (uint32_t a = 0; a < channelCount; ++a)
+			for (uint32_t b = 0; b < a; ++b)
+				covariance[a][b] = covariance[b][a];
+
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (uint32_t iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (uint32_t a = 0; a < channelCount; ++a)
+			{
+				for (uint32_t b = 0; b < channelCount; ++b)
+					next[a] += covariance[a][b] * axis[b];
+				length = std::max(length, std::abs(next[a]));
+			}
+
+			if (length < 1e-6f)
+				break;
+
+			for (uint32_t a = 0; a < channelCount; ++a)
+				axis[a] = next[a] / length;
+		}
+
+		float minProjection = 0.0f, maxProjection = 0.0f;
+		float axisLength = 0.0f;
+		for (uint32_t c = 0; c < channelCount; ++c)
+			axisLength += axis[c] * axis[c];
+
+		for (size_t i = 0; i < 16; ++i)
+		{
+			float projection = 0.0f;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				projection += (block.channels[c][i] - mean[c]) * axis[c];
+			projection /= axisLength;
+
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			start[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+			end[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+		}
+	}
+
+	//nearest palette entry for every pixel, palette is stored as [entry][channel]
+	void selectIndices(const Block& block, uint32_t channelCount, const float (*palette)[4], uint32_t paletteSize, uint8_t* indices)
+	{
+#ifdef BLOCK_COMPRESSION_SSE2
+		for (size_t i = 0; i < 16; i += 4)
+		{
+			__m128 bestDistance = _mm_set1_ps(1e30f);
+			__m128 bestIndex = _mm_setzero_ps();
+
+			for (uint32_t p = 0; p < paletteSize; ++p)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					__m128 difference = _mm_sub_ps(_mm_load_ps(&block.channels[c][i]), _mm_set1_ps(palette[p][c]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+				}
+
+				__m128 closer = _mm_cmplt_ps(distance, bestDistance);
+				bestDistance = _mm_min_ps(distance, bestDistance);
+				bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps(static_cast<float>(p))), _mm_andnot_ps(closer, bestIndex));
+			}
+
+			alignas(16) int32_t result[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(result), _mm_cvttps_epi32(bestIndex));
+			for (size_t j = 0; j < 4; ++j)
+				indices[i + j] = static_cast<uint8_t>(result[j]);
+		}
+#else
+		for (size_t i = 0; i < 16; ++i)
+		{
+			float bestDistance = 1e30f;
+			for (uint32_t p = 0; p < paletteSize; ++p)
+			{
+				float distance = 0.0f;
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					float difference = block.channels[c][i] - palette[p][c];
+					distance += difference * difference;
+				}
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[i] = static_cast<uint8_t>(p);
+				}
+			}
+		}
+#endif
+	}
+
+	uint16_t packRgb565(const float* color)
+	{
+		uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpackRgb565(uint16_t packed, float* color)
+	{
+		uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+
+	void buildColorPalette(uint16_t color0, uint16_t color1, float (*palette)[4])
+	{
+		unpackRgb565(color0, palette[0]);
+		unpackRgb565(color1, palette[1]);
+
+		for (size_t c = 0; c < 4; ++c)
+		{
+			if (color0 > color1)
+			{
+				palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+				palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+			}
+			else
+			{
+				palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+				palette[3][c] = 0.0f;
+			}
+		}
+	}
+
+	void encodeColor(const Block& block, uint8_t* output)
+	{
+		float start[4], end[4];
+		findEndpoints(block, 3, start, end);
+
+		uint16_t color0 = packRgb565(end);
+		uint16_t color1 = packRgb565(start);
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		uint8_t indices[16] = {};
+		if (color0 != color1)
+		{
+			float palette[4][4];
+			buildColorPalette(color0, color1, palette);
+			selectIndices(block, 3, palette, 4, indices);
+		}
+
+		uint32_t packedIndices = 0;
+		for (size_t i = 0; i < 16; ++i)
+			packedIndices |= static_cast<uint32_t>(indices[i]) << (i * 2);
+
+		memcpy(output, &color0, 2);
+		memcpy(output + 2, &color1, 2);
+		memcpy(output + 4, &packedIndices, 4);
+	}
+
+	void buildAlphaPalette(uint8_t alpha0, uint8_t alpha1, float (*palette)[4])
+	{
+		palette[0][0] = alpha0;
+		palette[1][0] = alpha1;
+
+		if (alpha0 > alpha1)
+		{
+			for (uint32_t i = 1; i < 7; ++i)
+				palette[i + 1][0] = static_cast<float>(((7 - i) * alpha0 + i * alpha1) / 7);
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; ++i)
+				palette[i + 1][0] = static_cast<float>(((5 - i) * alpha0 + i * alpha1) / 5);
+			palette[6][0] = 0.0f;
+			palette[7][0] = 255.0f;
+		}
+	}
+
+	void encodeAlpha(const Block& block, uint8_t* output)
+	{
+		const float* alpha = block.channels[3];
+		uint8_t alpha0 = static_cast<uint8_t>(*std::max_element(alpha, alpha + 16));
+		uint8_t alpha1 = static_cast<uint8_t>(*std::min_element(alpha, alpha + 16));
+
+		uint8_t indices[16] = {};
+		if (alpha0 != alpha1)
+		{
+			//alpha is searched as a one channel palette, the block is shifted so channel 0 is alpha
+			Block alphaBlock;
+			memcpy(alphaBlock.channels[0], alpha, sizeof(alphaBlock.channels[0]));
+
+			float palette[8][4];
+			buildAlphaPalette(alpha0, alpha1, palette);
+			selectIndices(alphaBlock, 1, palette, 8, indices);
+		}
+
+		memset(output, 0, 8);
+		output[0] = alpha0;
+		output[1] = alpha1;
+
+		BitWriter writer{ output + 2 };
+		for (size_t i = 0; i < 16; ++i)
+			writer.write(indices[i], 3);
+	}
+
+	//mode 6: one subset, rgba 7 bit endpoints with a shared low bit per endpoint, 4 bit indices
+	void quantizeBc7Endpoint(const float* endpoint, uint32_t* quantized, uint32_t& pBit)
+	{
+		float bestError = 1e30f;
+		for (uint32_t p = 0; p < 2; ++p)
+		{
+			uint32_t candidate[4];
+			float error = 0.0f;
+			for (size_t c = 0; c < 4; ++c)
+			{
+				float value = std::clamp(std::round((endpoint[c] - p) / 2.0f), 0.0f, 127.0f);
+				candidate[c] = static_cast<uint32_t>(value);
+				float difference = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	void buildBc7Palette(const uint32_t* quantized0, uint32_t pBit0, const uint32_t* quantized1, uint32_t pBit1, float (*palette)[4])
+	{
+		for (size_t c = 0; c < 4; ++c)
+		{
+			uint32_t endpoint0 = (quantized0[c] << 1) | pBit0;
+			uint32_t endpoint1 = (quantized1[c] << 1) | pBit1;
+			for (size_t i = 0; i < 16; ++i)
+				palette[i][c] = static_cast<float>(((64 - bc7Weights[i]) * endpoint0 + bc7Weights[i] * endpoint1 + 32) >> 6);
+		}
+	}
+
+	void encodeBc7(const Block& block, uint8_t* output)
+	{
+		float start[4], end[4];
+		findEndpoints(block, 4, start, end);
+
+		uint32_t quantized[2][4], pBits[2];
+		quantizeBc7Endpoint(start, quantized[0], pBits[0]);
+		quantizeBc7Endpoint(end, quantized[1], pBits[1]);
+
+		float palette[16][4];
+		buildBc7Palette(quantized[0], pBits[0], quantized[1], pBits[1], palette);
+
+		uint8_t indices[16];
+		selectIndices(block, 4, palette, 16, indices);
+
+		//the msb of the first index is implicit zero, swapping the endpoints flips every index
+		if (indices[0] & 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (size_t i = 0; i < 16; ++i)
+				indices[i] = 15 - indices[i];
+		}
+
+		memset(output, 0, 16);
+		BitWriter writer{ output };
+		writer.write(1 << 6, 7);
+		for (size_t c = 0; c < 4; ++c)
+		{
+			writer.write(quantized[0][c], 7);
+			writer.write(quantized[1][c], 7);
+		}
+		writer.write(pBits[0], 1);
+		writer.write(pBits[1], 1);
+
+		writer.write(indices[0], 3);
+		for (size_t i = 1; i < 16; ++i)
+			writer.write(indices[i], 4);
+	}
+
+	void decodeColor(const uint8_t* input, uint8_t* rgba, bool writeAlpha)
+	{
+		uint16_t color0, color1;
+		uint32_t packedIndices;
+		memcpy(&color0, input, 2);
+		memcpy(&color1, input + 2, 2);
+		memcpy(&packedIndices, input + 4, 4);
+
+		float palette[4][4];
+		buildColorPalette(color0, color1, palette);
+
+		for (size_t i = 0; i < 16; ++i)
+		{
+			const float* color = palette[(packedIndices >> (i * 2)) & 3];
+			for (size_t c = 0; c < (writeAlpha ? 4u : 3u); ++c)
+				rgba[i * 4 + c] = static_cast<uint8_t>(color[c]);
+		}
+	}
+
+	void decodeAlpha(const uint8_t* input, uint8_t* rgba)
+	{
+		float palette[8][4];
+		buildAlphaPalette(input[0], input[1], palette);
+
+		BitReader reader{ input + 2 };
+		for (size_t i = 0; i < 16; ++i)
+			rgba[i * 4 + 3] = static_cast<uint8_t>(palette[reader.read(3)][0]);
+	}
+
+	void decodeBc7(const uint8_t* input, uint8_t* rgba)
+	{
+		BitReader reader{ input };
+
+		//only mode 6 is ever written by the encoder, anything else decodes to transparent black
+		if (reader.read(7) != 1 << 6)
+		{
+			memset(rgba, 0, 64);
+			return;
+		}
+
+		uint32_t quantized[2][4];
+		for (size_t c = 0; c < 4; ++c)
+		{
+			quantized[0][c] = reader.read(7);
+			quantized[1][c] = reader.read(7);
+		}
+		uint32_t pBit0 = reader.read(1);
+		uint32_t pBit1 = reader.read(1);
+
+		float palette[16][4];
+		buildBc7Palette(quantized[0], pBit0, quantized[1], pBit1, palette);
+
+		for (size_t i = 0; i < 16; ++i)
+		{
+			const float* color = palette[reader.read(i == 0 ? 3 : 4)];
+			for (size_t c = 0; c < 4; ++c)
+				rgba[i * 4 + c] = static_cast<uint8_t>(color[c]);
+		}
+	}
+
+	//copies a 4x4 block out of the image, blocks over the edge repeat the last row/column
+	void readBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* rgba)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+				memcpy(rgba + (y * 4 + x) * 4, pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+			}
+		}
+	}
+}
+
+namespace BlockCompression
+{
+	size_t getBlockSize(BlockFormat format) noexcept
+	{
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height) noexcept
+	{
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+	}
+
+	void compressBlock(BlockFormat format, const uint8_t* rgba, uint8_t* block)
+	{
+		Block pixels = loadBlock(rgba);
+
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			encodeColor(pixels, block);
+			break;
+		case BlockFormat::BC3:
+			encodeAlpha(pixels, block);
+			encodeColor(pixels, block + 8);
+			break;
+		case BlockFormat::BC7:
+			encodeBc7(pixels, block);
+			break;
+		}
+	}
+
+	void decompressBlock(BlockFormat format, const uint8_t* block, uint8_t* rgba)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			decodeColor(block, rgba, true);
+			break;
+		case BlockFormat::BC3:
+			decodeColor(block + 8, rgba, false);
+			decodeAlpha(block, rgba);
+			break;
+		case BlockFormat::BC7:
+			decodeBc7(block, rgba);
+			break;
+		}
+	}
+
+	std::vector<uint8_t> compress(BlockFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t threadCount)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		const size_t blockSize = getBlockSize(format);
+
+		std::vector<uint8_t> blocks(getCompressedSize(format, width, height));
+
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		threadCount = std::min(threadCount, blocksY);
+
+		//rows of blocks are handed out one at a time so uneven rows dont leave threads idle
+		std::atomic<uint32_t> nextRow = 0;
+		auto worker = [&]() {
+			uint8_t rgba[64];
+			for (uint32_t blockY = nextRow++; blockY < blocksY; blockY = nextRow++)
+			{
+				for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+				{
+					readBlock(pixels, width, height, blockX, blockY, rgba);
+					compressBlock(format, rgba, blocks.data() + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize);
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < threadCount; ++i)
+			threads.emplace_back(worker);
+		worker();
+
+		for (auto& thread : threads)
+			thread.join();
+
+		return blocks;
+	}
+
+	std::vector<uint8_t> decompress(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		const size_t blockSize = getBlockSize(format);
+
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4, 255);
+		uint8_t rgba[64];
+
+		for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+			{
+				memset(rgba, 255, sizeof(rgba));
+				decompressBlock(format, blocks + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize, rgba);
+
+				for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y)
+				{
+					for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+					{
+						size_t pixel = (static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4;
+						memcpy(pixels.data() + pixel, rgba + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+
+		return pixels;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+enum class BlockFormat : uint32_t
+{
+	BC1 = 1,
+	BC3 = 3,
+	BC7 = 7
+};
+
+//4x4 block encoders for rgba8 images, bc1 is opaque, bc7 only emits mode 6
+namespace BlockCompression
+{
+	size_t getBlockSize(BlockFormat format) noexcept;
+	size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height) noexcept;
+	void compressBlock(BlockFormat format, const uint8_t* rgba, uint8_t* block);
+	void decompressBlock(BlockFormat format, const uint8_t* block, uint8_t* rgba);
+	std::vector<uint8_t> compress(BlockFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t threadCount = 0);
+	std::vector<uint8_t> decompress(BlockFormat format, const uint8_t* blocks, uint32_t width, uint32_t height);
+}
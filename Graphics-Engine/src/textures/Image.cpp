@@ -1,21 +1,39 @@
+#include <algorithm>
+#include <filesystem>
 #include "Image.hpp"
 #include "../utils/assert.hpp"
 #include "../vulkan/Pipeline.hpp"
+#include "../vulkan/TextureTable.hpp"
+#include "../utils/Logger.hpp"
 
-Image::Image(const Vk::Device& device, const std::string& path, const glm::vec2& dimensions, 
-	const VkCommandPool commandPool, int32_t format
-)
-	:device(device), dimensions(dimensions)
+Image::Image(const Vk::Device& device, const std::string& path, const glm::vec2& dimensions, int32_t format)
+	:Image(device, dimensions)
 {
-	init(path, commandPool, format);
+	upload(decode(device, path, format));
 }
 
+Image::Image(const Vk::Device& device, const glm::vec2& dimensions)
+	:device(device), dimensions(dimensions), image(VK_NULL_HANDLE), imageFormat(VK_FORMAT_R8G8B8A8_SRGB), imageView(VK_NULL_HANDLE),
+	imageSize(0), mipLevels(1), imageSampler(VK_NULL_HANDLE), uploadToken(0),
+	textureIndex(Vk::TextureTable::fallbackIndex)
+{
+	createMesh();
+}
+
+//frames in flight and cached command buffers can still sample the texture, it goes away with its table slot
 Image::~Image() noexcept
 {
-	vkDestroySampler(device.getLogicalDevice(), imageSampler, nullptr);
-	vkDestroyImageView(device.getLogicalDevice(), imageView, nullptr);
-	vkDestroyImage(device.getLogicalDevice(), image, nullptr);
-	vkFreeMemory(device.getLogicalDevice(), imageMemory, nullptr);
+	auto destroy = [&device = device, sampler = imageSampler, view = imageView, image = image, memory = imageMemory]() mutable {
+		vkDestroySampler(device.getLogicalDevice(), sampler, nullptr);
+		vkDestroyImageView(device.getLogicalDevice(), view, nullptr);
+		vkDestroyImage(device.getLogicalDevice(), image, nullptr);
+		device.getAllocator().free(memory);
+	};
+
+	if (image != VK_NULL_HANDLE)
+		device.getTextureTable().remove(textureIndex, std::move(destroy));
+	else
+		destroy();
 }
 
 const VkImageView Image::getImageView() const noexcept
@@ -28,57 +46,169 @@ const VkSampler Image::getSampler() const noexcept
 	return imageSampler;
 }
 
-void Image::draw(VkCommandBuffer commandBuffer, const VkPipelineLayout pipelineLayout, const Vk::Camera& camera) const
+//the quad itself is gated by getUploadToken, the texture by this
+bool Image::isReady() const
 {
-		VkBuffer rawVertexBuffer = vertexBuffer->getBuffer();
-		VkDeviceSize offset = 0;
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &rawVertexBuffer, &offset);
+	return image != VK_NULL_HANDLE && device.getUploadContext().isComplete(uploadToken);
+}
 
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-		Vk::PushConstant push{};
-		push.model = transform.getModel();
-		push.viewProjection = camera.getViewProjection();
+//slot in the texture table to sample, the fallback until the upload has landed
+uint32_t Image::getTextureIndex() const
+{
+	return isReady() ? textureIndex : Vk::TextureTable::fallbackIndex;
+}
+
+namespace
+{
+	VkFormat getBlockFormat(BlockFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case BlockFormat::BC3:
+			return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+		case BlockFormat::BC7:
+			return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+		}
+
+		assert(false, "unknown block format");
+		return VK_FORMAT_UNDEFINED;
+	}
 
-		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Vk::PushConstant), &push);
+	//texel rows one row of blocks covers, compressed levels can only be split between block rows
+	uint32_t getBlockHeight(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+			return 4;
+		default:
+			return 1;
+		}
+	}
+}
 
-        vkCmdDrawIndexed(commandBuffer, indexBuffer->getVertexCount(), 1, 0, 0, 0);
+ImageSource Image::decode(const Vk::Device& device, const std::string& path, int32_t format)
+{
+	//a baked .tex next to the source image skips decoding it
+	std::filesystem::path texturePath = std::filesystem::path(path).replace_extension(".tex");
+	if (std::filesystem::exists(texturePath))
+		return decodeTextureFile(device, texturePath.string());
 
-		//transform.rotation.y = transform.rotation.y + 0.001;
-		transform.scale.x += 0.001;
-		if (transform.scale.x > 2.5f)
-			transform.scale.x = 1;
+	return decodeImage(device, path, format);
 }
 
-void Image::init(const std::string& path, const VkCommandPool commandPool, int32_t format)
+ImageSource Image::decodeImage(const Vk::Device& device, const std::string& path, int32_t format)
 {
-	auto [buffer, width, height] = loadImage(path, format);
-	createVkImage(width, height);
-    allocateMemory();
+	ImageSource source;
 
-	transferLayout(commandPool, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	copyFromBuffer(commandPool, buffer, width, height);
-	transferLayout(commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	int32_t width, height, channels;
+	source.pixels.reset(stbi_load(path.c_str(), &width, &height, &channels, format));
+	assert(source.pixels != nullptr, "cant load image");
 
-	createVkImageView(device);
-	createVkImageSampler();
+	source.width = static_cast<uint32_t>(width);
+	source.height = static_cast<uint32_t>(height);
+	source.levelCount = MipChain::getLevelCount(source.width, source.height);
+
+	source.blitMipmaps = isFormatSupported(device, source.format,
+		VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+
+	if (source.blitMipmaps)
+	{
+		source.data = source.pixels.get();
+		source.size = static_cast<VkDeviceSize>(width) * height * 4;
+		source.levels = { { source.width, source.height, 0, static_cast<size_t>(source.size) } };
+	}
+	else
+	{
+		//format cant be linearly blitted on this device, filter the chain on the cpu instead
+		source.chain = MipChain::build(source.pixels.get(), source.width, source.height, true, source.levelCount);
+		source.pixels.reset();
+		source.data = source.chain.data.data();
+		source.size = source.chain.data.size();
+		source.levels = source.chain.levels;
+	}
 
-	createBuffers(commandPool);
+	return source;
 }
 
-std::tuple<std::unique_ptr<Vk::Buffer>, int32_t, int32_t> Image::loadImage(const std::string& path, int32_t format)
+ImageSource Image::decodeTextureFile(const Vk::Device& device, const std::string& path)
 {
-	int32_t width, height, channels;
-	stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, format);
+	ImageSource source;
+	const TextureFile& texture = source.textureFile.emplace(path);
 
-	assert(pixels != nullptr, "cant load image");
+	source.width = texture.getWidth();
+	source.height = texture.getHeight();
+	source.levelCount = texture.getLevelCount();
 
-	imageSize = static_cast<VkDeviceSize>(width) * height * 4;
-	auto transferBuffer = std::make_unique<Vk::Buffer>(device, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	transferBuffer->setData(pixels, imageSize);
+	if (texture.isCompressed())
+		source.format = getBlockFormat(texture.getFormat(), texture.isSrgb());
+	else
+		source.format = texture.isSrgb() ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+	//levels are read straight from the mapped file into the staging ring
+	source.data = texture.getData();
+	source.size = texture.getDataSize();
+
+	for (uint32_t i = 0; i < source.levelCount; ++i)
+	{
+		const TextureFileLevel& level = texture.getLevel(i);
+		source.levels.push_back({ level.width, level.height, static_cast<size_t>(level.offset - texture.getLevel(0).offset), static_cast<size_t>(level.size) });
+	}
 
-	stbi_image_free(pixels);
+	//devices without bc support get the decoded pixels instead
+	if (texture.isCompressed() && !isFormatSupported(device, source.format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+	{
+		LOG_WARNING("block compressed format not supported, decompressing " + path);
+		source.format = texture.isSrgb() ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+		for (uint32_t i = 0; i < source.levelCount; ++i)
+		{
+			const MipLevel& level = source.levels[i];
+			auto pixels = BlockCompression::decompress(texture.getFormat(), texture.getLevelData(i), level.width, level.height);
+			source.chain.levels.push_back({ level.width, level.height, source.chain.data.size(), pixels.size() });
+			source.chain.data.insert(source.chain.data.end(), pixels.begin(), pixels.end());
+		}
+
+		source.data = source.chain.data.data();
+		source.size = source.chain.data.size();
+		source.levels = source.chain.levels;
+	}
 
-	return std::make_tuple(std::move(transferBuffer), width, height);
+	return source;
+}
+
+void Image::upload(const ImageSource& source)
+{
+	assert(image == VK_NULL_HANDLE, "image was already uploaded");
+
+	imageFormat = source.format;
+	imageSize = source.size;
+	mipLevels = source.levelCount;
+
+	createVkImage(source.width, source.height);
+	allocateMemory();
+
+	transferLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	copyFromStaging(source.data, source.size, source.levels);
+
+	if (source.blitMipmaps)
+		generateMipmaps(source.width, source.height);
+	else
+		transferLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	uploadToken = device.getUploadContext().getToken();
+
+	createVkImageView(device);
+	createVkImageSampler();
+
+	textureIndex = device.getTextureTable().add(imageView, imageSampler);
 }
 
 void Image::createVkImage(int32_t width, int32_t height)
@@ -89,12 +219,12 @@ void Image::createVkImage(int32_t width, int32_t height)
     imageInfo.extent.width = static_cast<uint32_t>(width);
     imageInfo.extent.height = static_cast<uint32_t>(height);
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
-    imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+    imageInfo.format = imageFormat;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -106,20 +236,13 @@ void Image::allocateMemory()
     VkMemoryRequirements memRequirements;
 	vkGetImageMemoryRequirements(device.getLogicalDevice(), image, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = device.getMemoryTypeIdx(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	assert(vkAllocateMemory(device.getLogicalDevice(), &allocInfo, nullptr, &imageMemory) == VK_SUCCESS, "cant allocate image memory");
+	imageMemory = device.getAllocator().allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
-	vkBindImageMemory(device.getLogicalDevice(), image, imageMemory, 0);
+	vkBindImageMemory(device.getLogicalDevice(), image, imageMemory.memory, imageMemory.offset);
 }
 
-void Image::transferLayout(const VkCommandPool commandPool, VkImageLayout oldLayout, VkImageLayout newLayout)
+void Image::transferLayout(VkImageLayout oldLayout, VkImageLayout newLayout)
 {
-    VkCommandBuffer commandBuffer = device.beginCommandBuffer(commandPool);
-
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.oldLayout = oldLayout;
@@ -129,7 +252,7 @@ void Image::transferLayout(const VkCommandPool commandPool, VkImageLayout oldLay
 	barrier.image = image;
 	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.levelCount = mipLevels;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
 
@@ -157,29 +280,148 @@ void Image::transferLayout(const VkCommandPool commandPool, VkImageLayout oldLay
 		assert(false, "unsupported layout transition!");
 	}
 
-	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	device.endCommandBuffer(commandBuffer, commandPool);
+	//the last transition hands the image over to the graphics queue
+	auto& uploadContext = device.getUploadContext();
+	if (newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		uploadContext.releaseToGraphics(barrier, sourceStage, destinationStage);
+	else
+		vkCmdPipelineBarrier(uploadContext.getCommandBuffer(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
-void Image::copyFromBuffer(const VkCommandPool commandPool, const std::unique_ptr<Vk::Buffer>& buffer, int32_t width, int32_t height)
+//an image that fits into a quarter of the staging ring is staged at once, a bigger one is split into bands of rows
+//of every level, each band is staged on its own so the upload context submits earlier bands when the ring runs full
+void Image::copyFromStaging(const uint8_t* data, VkDeviceSize size, const std::vector<MipLevel>& levels)
 {
-	VkCommandBuffer commandBuffer = device.beginCommandBuffer(commandPool);
+	auto& uploadContext = device.getUploadContext();
+	const VkDeviceSize maxBandSize = device.getStagingRing().getCapacity() / 4;
 
 	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
 	region.imageSubresource.baseArrayLayer = 0;
 	region.imageSubresource.layerCount = 1;
-	region.imageOffset = {0, 0, 0};
-	region.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
 
-	vkCmdCopyBufferToImage(commandBuffer, buffer->getBuffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	if (size <= maxBandSize)
+	{
+		auto staging = uploadContext.stage(data, size);
+
+		std::vector<VkBufferImageCopy> regions(levels.size(), region);
+		for (uint32_t i = 0; i < levels.size(); ++i)
+		{
+			regions[i].bufferOffset = staging.offset + levels[i].offset;
+			regions[i].imageSubresource.mipLevel = i;
+			regions[i].imageOffset = {0, 0, 0};
+			regions[i].imageExtent = { levels[i].width, levels[i].height, 1 };
+		}
+
+		vkCmdCopyBufferToImage(uploadContext.getCommandBuffer(), staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+		return;
+	}
 
-	device.endCommandBuffer(commandBuffer, commandPool);
+	const uint32_t blockHeight = getBlockHeight(imageFormat);
+	for (uint32_t i = 0; i < levels.size(); ++i)
+	{
+		const MipLevel& level = levels[i];
+		const uint32_t blockRows = (level.height + blockHeight - 1) / blockHeight;
+		const VkDeviceSize rowSize = level.size / blockRows;
+		assert(rowSize <= maxBandSize, "image row is bigger than the staging ring");
+		const uint32_t bandRows = static_cast<uint32_t>(std::min<VkDeviceSize>(maxBandSize / rowSize, blockRows));
+
+		for (uint32_t row = 0; row < blockRows; row += bandRows)
+		{
+			const uint32_t rowCount = std::min(bandRows, blockRows - row);
+			//staging can submit the open batch, so the command buffer is asked for after it
+			auto staging = uploadContext.stage(data + level.offset + row * rowSize, rowCount * rowSize);
+
+			region.bufferOffset = staging.offset;
+			region.imageSubresource.mipLevel = i;
+			region.imageOffset = { 0, static_cast<int32_t>(row * blockHeight), 0 };
+			region.imageExtent = { level.width, std::min(rowCount * blockHeight, level.height - row * blockHeight), 1 };
+			vkCmdCopyBufferToImage(uploadContext.getCommandBuffer(), staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		}
+	}
+}
+
+void Image::generateMipmaps(int32_t width, int32_t height)
+{
+	auto& uploadContext = device.getUploadContext();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	//blits need a graphics queue, the whole chain is handed over still in transfer dst layout
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	uploadContext.releaseToGraphics(barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	VkCommandBuffer commandBuffer = uploadContext.getGraphicsCommandBuffer();
+	barrier.subresourceRange.levelCount = 1;
+
+	int32_t mipWidth = width;
+	int32_t mipHeight = height;
+	for (uint32_t i = 1; i < mipLevels; ++i)
+	{
+		barrier.subresourceRange.baseMipLevel = i - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		int32_t nextWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+		int32_t nextHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+
+		VkImageBlit blit{};
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = i;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+		vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		mipWidth = nextWidth;
+		mipHeight = nextHeight;
+	}
+
+	barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+bool Image::isFormatSupported(const Vk::Device& device, VkFormat format, VkFormatFeatureFlags features)
+{
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(device.getPhysicalDevice(), format, &properties);
+
+	return (properties.optimalTilingFeatures & features) == features;
 }
 
 void Image::createVkImageView(const Vk::Device& device)
@@ -188,10 +430,10 @@ void Image::createVkImageView(const Vk::Device& device)
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	viewInfo.image = image;
 	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+	viewInfo.format = imageFormat;
 	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	viewInfo.subresourceRange.baseMipLevel = 0;
-	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.levelCount = mipLevels;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
 	viewInfo.subresourceRange.layerCount = 1;
 
@@ -220,31 +462,14 @@ void Image::createVkImageSampler()
 	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	samplerInfo.mipLodBias = 0.0f;
 	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = 0.0f;
+	samplerInfo.maxLod = static_cast<float>(mipLevels);
 
 	assert(vkCreateSampler(device.getLogicalDevice(), &samplerInfo, nullptr, &imageSampler) == VK_SUCCESS, "cant create image sampler");
 }
 
-void Image::createBuffers(const VkCommandPool commandPool)
-{
-	std::vector<Vk::Vertex> vertices(4, { glm::vec3{0.0f}, glm::vec3{0.0f} });
-	vertices[0].position.x = -dimensions.x / 2.0f;
-	vertices[0].position.y = -dimensions.y / 2.0f;
-	vertices[0].texCord = glm::vec2{ 1.0f, 0.0f };
-	vertices[1].position.x = dimensions.x / 2.0f;
-	vertices[1].position.y = -dimensions.y / 2.0f;
-	vertices[1].texCord = glm::vec2{ 0.0f };
-	vertices[2].position.x = dimensions.x / 2.0f;
-	vertices[2].position.y = dimensions.y / 2.0f;
-	vertices[2].texCord = glm::vec2{ 0.0f, 1.0f };
-	vertices[3].position.x = -dimensions.x / 2.0f;
-	vertices[3].position.y = dimensions.y / 2.0f;
-	vertices[3].texCord = glm::vec2{ 1.0f };
-	
-	std::vector<uint32_t> indices = {
-		0, 1, 2, 2, 3, 0
-	};
-
-	vertexBuffer = std::make_unique<Vk::Buffer>(device, vertices, commandPool);
-	indexBuffer = std::make_unique<Vk::Buffer>(device, indices, commandPool);
+//the quad is shared by every image, the size is the scale of the transform
+void Image::createMesh()
+{
+	mesh = device.getGeometryBuffer().getQuad();
+	transform.scale = glm::vec3{ dimensions, 1.0f };
 }
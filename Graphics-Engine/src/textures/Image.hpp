@@ -2,44 +2,75 @@
 
 #include <stb/stb_image.h>
 #include <string>
+#include <memory>
+#include <optional>
 #include "../vulkan/device.hpp"
 #include "../vulkan/Buffer.hpp"
 #include "../vulkan/Renderable.hpp"
+#include "MipChain.hpp"
+#include "TextureFile.hpp"
 
+//cpu side of an image, producing it touches no vulkan state so it can run on any thread
+//data points into whichever of pixels, textureFile or chain holds the levels
+struct ImageSource
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+	uint32_t levelCount = 1;
+	bool blitMipmaps = false; //only level 0 is in data, the rest is blitted on the gpu
+	const uint8_t* data = nullptr;
+	VkDeviceSize size = 0;
+	std::vector<MipLevel> levels;
+
+	std::unique_ptr<stbi_uc, void(*)(void*)> pixels{ nullptr, stbi_image_free };
+	std::optional<TextureFile> textureFile;
+	MipChain chain;
+};
+
+//drawn as the shared unit quad, the scale of its transform is its size
 class Image : public Vk::Renderable
 {
 public:
-	explicit Image(const Vk::Device& device, const std::string& path, const glm::vec2& dimensions, const VkCommandPool commandPool, 
-		int32_t format = STBI_rgb_alpha
-	);
+	explicit Image(const Vk::Device& device, const std::string& path, const glm::vec2& dimensions, int32_t format = STBI_rgb_alpha);
+	explicit Image(const Vk::Device& device, const glm::vec2& dimensions);
 	~Image() noexcept;
 
 	Image(const Image&) = delete;
 	Image(Image&&) = default;
 	Image& operator=(const Image&) = delete;
 
+	void upload(const ImageSource& source);
+	bool isReady() const;
+	uint32_t getTextureIndex() const override;
 	const VkImageView getImageView() const noexcept;
 	const VkSampler getSampler() const noexcept;
-	void draw(VkCommandBuffer commandBuffer, const VkPipelineLayout pipelineLayout, const Vk::Camera& camera) const override;
+
+	static ImageSource decode(const Vk::Device& device, const std::string& path, int32_t format = STBI_rgb_alpha);
 	
 private:
-	void init(const std::string& path, const VkCommandPool commandPool, int32_t format);
-	std::tuple<std::unique_ptr<Vk::Buffer>, int32_t, int32_t> loadImage(const std::string& path, int32_t format);
+	static ImageSource decodeImage(const Vk::Device& device, const std::string& path, int32_t format);
+	static ImageSource decodeTextureFile(const Vk::Device& device, const std::string& path);
+	static bool isFormatSupported(const Vk::Device& device, VkFormat format, VkFormatFeatureFlags features);
 	void createVkImage(int32_t width, int32_t height);
 	void allocateMemory();
-	void transferLayout(const VkCommandPool commandPool, VkImageLayout oldLayout, VkImageLayout newLayout);
-	void copyFromBuffer(const VkCommandPool commandPool, const std::unique_ptr<Vk::Buffer>& buffer, int32_t width, int32_t height);
+	void transferLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
+	void copyFromStaging(const uint8_t* data, VkDeviceSize size, const std::vector<MipLevel>& levels);
+	void generateMipmaps(int32_t width, int32_t height);
 	void createVkImageView(const Vk::Device& device);
 	void createVkImageSampler();
-	void createBuffers(const VkCommandPool commandPool);
+	void createMesh();
 
 private:
 	const Vk::Device& device;
 	glm::vec2 dimensions;
 	VkImage image;
+	VkFormat imageFormat;
 	VkImageView imageView;
-	VkDeviceMemory imageMemory;
+	Vk::Allocation imageMemory;
 	VkDeviceSize imageSize;
+	uint32_t mipLevels;
 	VkSampler imageSampler;
+	Vk::UploadToken uploadToken;
+	uint32_t textureIndex;
 };
-
@@ -0,0 +1,115 @@
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "MipChain.hpp"
+
+namespace
+{
+	constexpr size_t linearToSrgbSize = 4096;
+
+	struct SrgbTables
+	{
+		std::array<float, 256> toLinear;
+		std::array<uint8_t, linearToSrgbSize> toSrgb;
+
+		SrgbTables()
+		{
+			for (size_t i = 0; i < toLinear.size(); ++i)
+			{
+				float c = static_cast<float>(i) / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (size_t i = 0; i < toSrgb.size(); ++i)
+			{
+				float c = static_cast<float>(i) / (linearToSrgbSize - 1);
+				float srgb = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+				toSrgb[i] = static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+		}
+	};
+
+	const SrgbTables& getSrgbTables()
+	{
+		static SrgbTables tables;
+		return tables;
+	}
+
+	//2x2 box filter, odd edges reuse the last row/column, color is averaged in linear space when srgb is set
+	void downsample(const uint8_t* source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* destination,
+		uint32_t width, uint32_t height, bool srgb)
+	{
+		const SrgbTables& tables = getSrgbTables();
+
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			const uint8_t* row0 = source + static_cast<size_t>(std::min(y * 2, sourceHeight - 1)) * sourceWidth * 4;
+			const uint8_t* row1 = source + static_cast<size_t>(std::min(y * 2 + 1, sourceHeight - 1)) * sourceWidth * 4;
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				size_t x0 = static_cast<size_t>(std::min(x * 2, sourceWidth - 1)) * 4;
+				size_t x1 = static_cast<size_t>(std::min(x * 2 + 1, sourceWidth - 1)) * 4;
+				uint8_t* pixel = destination + (static_cast<size_t>(y) * width + x) * 4;
+
+				for (size_t c = 0; c < 3; ++c)
+				{
+					if (srgb)
+					{
+						float sum = tables.toLinear[row0[x0 + c]] + tables.toLinear[row0[x1 + c]] + tables.toLinear[row1[x0 + c]] + tables.toLinear[row1[x1 + c]];
+						pixel[c] = tables.toSrgb[static_cast<size_t>(sum * 0.25f * (linearToSrgbSize - 1) + 0.5f)];
+					}
+					else
+					{
+						pixel[c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+					}
+				}
+
+				pixel[3] = static_cast<uint8_t>((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) / 4);
+			}
+		}
+	}
+}
+
+uint32_t MipChain::getLevelCount(uint32_t width, uint32_t height) noexcept
+{
+	uint32_t levelCount = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+		levelCount++;
+
+	return levelCount;
+}
+
+MipChain MipChain::build(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, uint32_t levelCount)
+{
+	if (levelCount == 0)
+		levelCount = getLevelCount(width, height);
+
+	MipChain chain;
+	chain.levels.reserve(levelCount);
+
+	size_t totalSize = 0;
+	for (uint32_t i = 0, w = width, h = height; i < levelCount; ++i)
+	{
+		size_t size = static_cast<size_t>(w) * h * 4;
+		chain.levels.push_back({ w, h, totalSize, size });
+		totalSize += size;
+
+		w = std::max(w / 2, 1u);
+		h = std::max(h / 2, 1u);
+	}
+
+	chain.data.resize(totalSize);
+	memcpy(chain.data.data(), pixels, chain.levels[0].size);
+
+	for (uint32_t i = 1; i < levelCount; ++i)
+	{
+		const MipLevel& source = chain.levels[i - 1];
+		const MipLevel& level = chain.levels[i];
+		downsample(chain.data.data() + source.offset, source.width, source.height, chain.data.data() + level.offset,
+			level.width, level.height, srgb);
+	}
+
+	return chain;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct MipLevel
+{
+	uint32_t width;
+	uint32_t height;
+	size_t offset;
+	size_t size;
+};
+
+//every level of a rgba8 image packed one after another, level 0 first
+struct MipChain
+{
+	std::vector<uint8_t> data;
+	std::vector<MipLevel> levels;
+
+	static uint32_t getLevelCount(uint32_t width, uint32_t height) noexcept;
+	static MipChain build(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, uint32_t levelCount = 0);
+};
@@ -0,0 +1,161 @@
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include "TextureFile.hpp"
+#include "MipChain.hpp"
+#include "../utils/assert.hpp"
+
+namespace
+{
+	//level data stays aligned to the biggest block so it can be copied straight into the staging ring
+	constexpr uint64_t levelAlignment = 16;
+
+	bool isKnownFormat(uint32_t format) noexcept
+	{
+		switch (format)
+		{
+		case textureFileUncompressed:
+		case static_cast<uint32_t>(BlockFormat::BC1):
+		case static_cast<uint32_t>(BlockFormat::BC3):
+		case static_cast<uint32_t>(BlockFormat::BC7):
+			return true;
+		}
+
+		return false;
+	}
+
+	//bytes a level of this size takes, the same the writer produces
+	uint64_t getLevelSize(uint32_t format, uint32_t width, uint32_t height) noexcept
+	{
+		if (format == textureFileUncompressed)
+			return static_cast<uint64_t>(width) * height * 4;
+
+		return BlockCompression::getCompressedSize(static_cast<BlockFormat>(format), width, height);
+	}
+}
+
+TextureFile::TextureFile(const std::string& path)
+	:file(path), header{}
+{
+	const uint8_t* bytes = file.getData();
+	const uint64_t fileSize = file.getSize();
+
+	assert(fileSize >= sizeof(TextureFileHeader), "not a texture file");
+	memcpy(&header, bytes, sizeof(TextureFileHeader));
+	assert(header.magic == textureFileMagic, "not a texture file");
+	assert(header.version == textureFileVersion, "unsupported texture file version");
+	assert(isKnownFormat(header.format), "unknown texture file format");
+	assert(header.width != 0 && header.height != 0, "texture file has no pixels");
+	assert(header.levelCount != 0, "texture file has no levels");
+	assert(header.levelCount <= MipChain::getLevelCount(header.width, header.height), "texture file has too many levels");
+
+	const uint64_t tableSize = sizeof(TextureFileLevel) * static_cast<uint64_t>(header.levelCount);
+	assert(sizeof(TextureFileHeader) + tableSize <= fileSize, "texture file is truncated");
+
+	levels.resize(header.levelCount);
+	memcpy(levels.data(), bytes + sizeof(TextureFileHeader), static_cast<size_t>(tableSize));
+
+	//every level has to be exactly what the gpu copy expects, a short one would be read past its end
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		const TextureFileLevel& level = levels[i];
+		assert(level.width == std::max(header.width >> i, 1u) && level.height == std::max(header.height >> i, 1u), "texture file level has wrong size");
+		assert(level.size == getLevelSize(header.format, level.width, level.height), "texture file level has wrong data size");
+		assert(level.offset % levelAlignment == 0, "texture file level is not aligned");
+		assert(level.offset <= fileSize && level.size <= fileSize - level.offset, "texture file is truncated");
+		assert(i == 0 || level.offset >= levels[i - 1].offset + levels[i - 1].size, "texture file levels overlap");
+	}
+}
+
+bool TextureFile::isCompressed() const noexcept
+{
+	return header.format != textureFileUncompressed;
+}
+
+BlockFormat TextureFile::getFormat() const noexcept
+{
+	return static_cast<BlockFormat>(header.format);
+}
+
+bool TextureFile::isSrgb() const noexcept
+{
+	return header.flags & textureFileSrgb;
+}
+
+uint32_t TextureFile::getWidth() const noexcept
+{
+	return header.width;
+}
+
+uint32_t TextureFile::getHeight() const noexcept
+{
+	return header.height;
+}
+
+uint32_t TextureFile::getLevelCount() const noexcept
+{
+	return header.levelCount;
+}
+
+const TextureFileLevel& TextureFile::getLevel(uint32_t level) const noexcept
+{
+	return levels[level];
+}
+
+const uint8_t* TextureFile::getLevelData(uint32_t level) const noexcept
+{
+	return file.getData() + levels[level].offset;
+}
+
+//every level from the first to the end of the last one, padding included
+const uint8_t* TextureFile::getData() const noexcept
+{
+	return getLevelData(0);
+}
+
+size_t TextureFile::getDataSize() const noexcept
+{
+	return static_cast<size_t>(levels.back().offset + levels.back().size - levels.front().offset);
+}
+
+void TextureFile::save(const std::string& path, std::optional<BlockFormat> format, bool srgb, uint32_t width, uint32_t height,
+	const std::vector<std::vector<uint8_t>>& levelData)
+{
+	TextureFileHeader header{};
+	header.magic = textureFileMagic;
+	header.version = textureFileVersion;
+	header.format = format ? static_cast<uint32_t>(*format) : textureFileUncompressed;
+	header.flags = srgb ? textureFileSrgb : 0;
+	header.width = width;
+	header.height = height;
+	header.levelCount = static_cast<uint32_t>(levelData.size());
+
+	std::vector<TextureFileLevel> levels(levelData.size());
+	uint64_t offset = sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * levels.size();
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		offset = (offset + levelAlignment - 1) / levelAlignment * levelAlignment;
+
+		levels[i].width = std::max(width >> i, 1u);
+		levels[i].height = std::max(height >> i, 1u);
+		levels[i].offset = offset;
+		levels[i].size = levelData[i].size();
+		offset += levels[i].size;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	assert(file.is_open(), "cant create texture file");
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levels.data()), sizeof(TextureFileLevel) * levels.size());
+
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		uint64_t padding = levels[i].offset - static_cast<uint64_t>(file.tellp());
+		const char zeros[levelAlignment] = {};
+		file.write(zeros, static_cast<std::streamsize>(padding));
+		file.write(reinterpret_cast<const char*>(levelData[i].data()), static_cast<std::streamsize>(levelData[i].size()));
+	}
+
+	assert(file.good(), "cant write texture file");
+}
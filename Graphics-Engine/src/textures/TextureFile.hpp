@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include "BlockCompression.hpp"
+#include "../utils/MappedFile.hpp"
+
+//engine texture container (.tex), little endian, written by Texture-Compressor
+//  TextureFileHeader                 32 bytes
+//  TextureFileLevel[levelCount]      24 bytes each, level 0 first
+//  level data                        every level starts at its offset, aligned to 16 bytes
+//format is a BlockFormat or textureFileUncompressed for rgba8, flags can hold textureFileSrgb
+//block levels are rows of 4x4 blocks, rgba8 levels are tightly packed rows of pixels
+//levels are laid out exactly as the gpu wants them so loading is a single copy into the staging ring
+constexpr uint32_t textureFileMagic = 0x58455445; //"ETEX"
+constexpr uint32_t textureFileVersion = 1;
+constexpr uint32_t textureFileUncompressed = 0;
+constexpr uint32_t textureFileSrgb = 1;
+
+struct TextureFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t flags;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint32_t reserved;
+};
+
+//offset is from the start of the file
+struct TextureFileLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;
+	uint64_t size;
+};
+
+//maps a .tex file and validates it, level data points straight into the mapping
+class TextureFile
+{
+public:
+	explicit TextureFile(const std::string& path);
+
+	TextureFile(const TextureFile&) = delete;
+	TextureFile(TextureFile&&) = default;
+	TextureFile& operator=(const TextureFile&) = delete;
+
+	bool isCompressed() const noexcept;
+	BlockFormat getFormat() const noexcept;
+	bool isSrgb() const noexcept;
+	uint32_t getWidth() const noexcept;
+	uint32_t getHeight() const noexcept;
+	uint32_t getLevelCount() const noexcept;
+	const TextureFileLevel& getLevel(uint32_t level) const noexcept;
+	const uint8_t* getLevelData(uint32_t level) const noexcept;
+	const uint8_t* getData() const noexcept;
+	size_t getDataSize() const noexcept;
+
+	//format is empty for uncompressed rgba8 levels
+	static void save(const std::string& path, std::optional<BlockFormat> format, bool srgb, uint32_t width, uint32_t height,
+		const std::vector<std::vector<uint8_t>>& levelData);
+
+private:
+	MappedFile file;
+	TextureFileHeader header;
+	std::vector<TextureFileLevel> levels;
+};
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include "TextureLoader.hpp"
+#include "../utils/Logger.hpp"
+
+TextureLoader::TextureLoader(const Vk::Device& device, uint32_t threadCount)
+	:device(device), threadPool(threadCount), batchSize(0)
+{
+}
+
+std::shared_ptr<Image> TextureLoader::load(const std::string& path, const glm::vec2& dimensions, int32_t format)
+{
+	if (requests.empty())
+	{
+		batchStart = std::chrono::high_resolution_clock::now();
+		batchSize = 0;
+	}
+
+	auto image = std::make_shared<Image>(device, dimensions);
+
+	auto source = threadPool.submit([&device = device, path, format]() {
+		return Image::decode(device, path, format);
+	});
+
+	requests.push_back({ path, image, std::move(source) });
+	++batchSize;
+
+	return image;
+}
+
+//uploads whatever finished decoding, never waits on a worker
+void TextureLoader::update()
+{
+	if (requests.empty())
+		return;
+
+	auto decoded = std::stable_partition(requests.begin(), requests.end(), [](const Request& request) {
+		return request.source.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+	});
+
+	for (auto request = decoded; request != requests.end(); ++request)
+		upload(*request);
+
+	requests.erase(decoded, requests.end());
+
+	if (requests.empty())
+	{
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - batchStart).count();
+		LOG_INFO("decoded " + STR(batchSize) + " textures on " + STR(threadPool.getThreadCount()) + " threads in " + STR(milliseconds) + " ms");
+	}
+}
+
+void TextureLoader::finish()
+{
+	for (auto& request : requests)
+		request.source.wait();
+
+	update();
+}
+
+size_t TextureLoader::getPendingCount() const noexcept
+{
+	return requests.size();
+}
+
+//a texture that fails to decode keeps showing the placeholder
+void TextureLoader::upload(Request& request)
+{
+	try
+	{
+		request.image->upload(request.source.get());
+	}
+	catch (const std::exception& exception)
+	{
+		LOG_ERROR(request.path + ": " + exception.what());
+	}
+}
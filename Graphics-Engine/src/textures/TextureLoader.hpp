@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <chrono>
+#include "Image.hpp"
+#include "../utils/ThreadPool.hpp"
+
+//decodes images on worker threads and uploads them from the render thread once they are decoded
+//images are handed out right away and report isReady once their upload has landed on the gpu
+class TextureLoader
+{
+public:
+	explicit TextureLoader(const Vk::Device& device, uint32_t threadCount = 0);
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	std::shared_ptr<Image> load(const std::string& path, const glm::vec2& dimensions, int32_t format = STBI_rgb_alpha);
+	void update();
+	void finish();
+	size_t getPendingCount() const noexcept;
+
+private:
+	struct Request
+	{
+		std::string path;
+		std::shared_ptr<Image> image;
+		std::future<ImageSource> source;
+	};
+
+	void upload(Request& request);
+
+private:
+	const Vk::Device& device;
+	ThreadPool threadPool;
+	std::vector<Request> requests;
+	std::chrono::high_resolution_clock::time_point batchStart;
+	size_t batchSize;
+};
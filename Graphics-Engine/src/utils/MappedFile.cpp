@@ -0,0 +1,115 @@
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+#include "MappedFile.hpp"
+#include "assert.hpp"
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+	:data(nullptr), size(0), fileHandle(nullptr), mappingHandle(nullptr)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	assert(file != INVALID_HANDLE_VALUE, "cant open file for mapping");
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		assert(false, "cant map empty file");
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle != nullptr)
+		data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+
+	if (data == nullptr)
+	{
+		close();
+		assert(false, "cant map file");
+	}
+}
+
+void MappedFile::close() noexcept
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mappingHandle != nullptr)
+		CloseHandle(mappingHandle);
+	if (fileHandle != nullptr)
+		CloseHandle(fileHandle);
+
+	data = nullptr;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	:data(other.data), size(other.size), fileHandle(other.fileHandle), mappingHandle(other.mappingHandle)
+{
+	other.data = nullptr;
+	other.fileHandle = nullptr;
+	other.mappingHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+	:data(nullptr), size(0)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	assert(file != -1, "cant open file for mapping");
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		::close(file);
+		assert(false, "cant map empty file");
+	}
+	size = static_cast<size_t>(status.st_size);
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	assert(mapping != MAP_FAILED, "cant map file");
+
+	data = static_cast<const uint8_t*>(mapping);
+	madvise(mapping, size, MADV_SEQUENTIAL);
+}
+
+void MappedFile::close() noexcept
+{
+	if (data != nullptr)
+		munmap(const_cast<uint8_t*>(data), size);
+
+	data = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	:data(other.data), size(other.size)
+{
+	other.data = nullptr;
+}
+
+#endif
+
+MappedFile::~MappedFile() noexcept
+{
+	close();
+}
+
+const uint8_t* MappedFile::getData() const noexcept
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const noexcept
+{
+	return size;
+}
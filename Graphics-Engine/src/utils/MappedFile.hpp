@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//read only mapping of a whole file, pages are read by the os on first access instead of copied up front
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile() noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+
+	const uint8_t* getData() const noexcept;
+	size_t getSize() const noexcept;
+
+private:
+	void close() noexcept;
+
+private:
+	const uint8_t* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
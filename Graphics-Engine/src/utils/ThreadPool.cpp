@@ -0,0 +1,51 @@
+#include <algorithm>
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+	:stopping(false)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	threads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; ++i)
+		threads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+uint32_t ThreadPool::getThreadCount() const noexcept
+{
+	return static_cast<uint32_t>(threads.size());
+}
+
+//queued tasks are still finished on shutdown so no future is left without a value
+void ThreadPool::work()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+			if (tasks.empty())
+				return;
+
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+
+		task();
+	}
+}
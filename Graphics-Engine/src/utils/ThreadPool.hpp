@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+//fixed set of worker threads pulling tasks from one queue
+class ThreadPool
+{
+public:
+	explicit ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template<typename Function>
+	auto submit(Function&& function) -> std::future<decltype(function())>
+	{
+		using Result = decltype(function());
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+		std::future<Result> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.emplace([task]() { (*task)(); });
+		}
+		condition.notify_one();
+
+		return result;
+	}
+
+	uint32_t getThreadCount() const noexcept;
+
+private:
+	void work();
+
+private:
+	std::vector<std::thread> threads;
+	std::queue<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping;
+};
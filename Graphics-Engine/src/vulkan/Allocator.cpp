@@ -0,0 +1,199 @@
+#include <algorithm>
+#include "Allocator.hpp"
+#include "Device.hpp"
+#include "../utils/assert.hpp"
+#include "../utils/Logger.hpp"
+
+namespace Vk
+{
+	Allocator::Allocator(const Device& device, VkDeviceSize blockSize)
+		:device(device), blockSize(blockSize)
+	{
+		vkGetPhysicalDeviceMemoryProperties(device.getPhysicalDevice(), &memoryProperties);
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+		maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+	}
+
+	Allocator::~Allocator()
+	{
+		for (auto& block : blocks)
+		{
+			if (block->usedSize != 0)
+				LOG_WARNING("memory block destroyed with live allocations");
+
+			if (block->mapped != nullptr)
+				vkUnmapMemory(device.getLogicalDevice(), block->memory);
+			vkFreeMemory(device.getLogicalDevice(), block->memory, nullptr);
+		}
+	}
+
+	Allocation Allocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		uint32_t memoryType = device.getMemoryTypeIdx(requirements.memoryTypeBits, properties);
+		Allocation allocation{};
+
+		if (requirements.size <= blockSize / 2)
+		{
+			for (auto& block : blocks)
+			{
+				if (block->memoryType != memoryType || block->linear != linear)
+					continue;
+
+				if (allocateFromBlock(*block, requirements.size, requirements.alignment, allocation))
+					return allocation;
+			}
+		}
+
+		//big resources get a block of their own so they dont fragment the shared ones
+		VkDeviceSize newBlockSize = std::max(blockSize, requirements.size);
+		MemoryBlock* block = createBlock(memoryType, linear, newBlockSize);
+
+		assert(allocateFromBlock(*block, requirements.size, requirements.alignment, allocation), "cant allocate from new memory block");
+		return allocation;
+	}
+
+	void Allocator::free(Allocation& allocation)
+	{
+		if (allocation.block == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		MemoryBlock& block = *allocation.block;
+		auto& freeRanges = block.freeRanges;
+
+		VkDeviceSize offset = allocation.offset;
+		VkDeviceSize size = allocation.size;
+
+		auto next = freeRanges.lower_bound(offset);
+		if (next != freeRanges.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = freeRanges.erase(next);
+		}
+
+		if (next != freeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				size += previous->second;
+				freeRanges.erase(previous);
+			}
+		}
+
+		freeRanges[offset] = size;
+		block.usedSize -= allocation.size;
+		allocation = Allocation{};
+
+		if (block.usedSize != 0)
+			return;
+
+		//keep one empty block per memory type around so a free/allocate pair doesnt hit the driver
+		bool hasSpareBlock = std::any_of(blocks.begin(), blocks.end(), [&](const auto& other) {
+			return other.get() != &block && other->memoryType == block.memoryType && other->linear == block.linear && other->usedSize == 0;
+		});
+
+		if (hasSpareBlock || block.size != blockSize)
+			destroyBlock(&block);
+	}
+
+	size_t Allocator::getBlockCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return blocks.size();
+	}
+
+	VkDeviceSize Allocator::getUsedSize() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VkDeviceSize usedSize = 0;
+		for (auto& block : blocks)
+			usedSize += block->usedSize;
+
+		return usedSize;
+	}
+
+	MemoryBlock* Allocator::createBlock(uint32_t memoryType, bool linear, VkDeviceSize size)
+	{
+		if (blocks.size() + 1 >= maxAllocationCount)
+			LOG_WARNING("memory block count is reaching maxMemoryAllocationCount");
+
+		auto block = std::make_unique<MemoryBlock>();
+		block->size = size;
+		block->usedSize = 0;
+		block->mapped = nullptr;
+		block->memoryType = memoryType;
+		block->linear = linear;
+		block->freeRanges[0] = size;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		assert(vkAllocateMemory(device.getLogicalDevice(), &allocInfo, nullptr, &block->memory) == VK_SUCCESS, "cant allocate memory block");
+
+		//host visible blocks stay mapped for their whole lifetime, vkMapMemory cant be called per sub allocation anyway
+		if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			assert(vkMapMemory(device.getLogicalDevice(), block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) == VK_SUCCESS, "cant map memory block");
+
+		blocks.push_back(std::move(block));
+		return blocks.back().get();
+	}
+
+	void Allocator::destroyBlock(MemoryBlock* block)
+	{
+		if (block->mapped != nullptr)
+			vkUnmapMemory(device.getLogicalDevice(), block->memory);
+		vkFreeMemory(device.getLogicalDevice(), block->memory, nullptr);
+
+		blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [block](const auto& other) {
+			return other.get() == block;
+		}), blocks.end());
+	}
+
+	bool Allocator::allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) const
+	{
+		if (block.size - block.usedSize < size)
+			return false;
+
+		auto& freeRanges = block.freeRanges;
+		for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range)
+		{
+			VkDeviceSize rangeOffset = range->first;
+			VkDeviceSize rangeSize = range->second;
+			VkDeviceSize alignedOffset = (rangeOffset + alignment - 1) / alignment * alignment;
+			VkDeviceSize padding = alignedOffset - rangeOffset;
+
+			if (rangeSize < padding + size)
+				continue;
+
+			freeRanges.erase(range);
+
+			if (padding != 0)
+				freeRanges[rangeOffset] = padding;
+
+			VkDeviceSize tailSize = rangeSize - padding - size;
+			if (tailSize != 0)
+				freeRanges[alignedOffset + size] = tailSize;
+
+			block.usedSize += size;
+
+			allocation.memory = block.memory;
+			allocation.offset = alignedOffset;
+			allocation.size = size;
+			allocation.block = &block;
+			allocation.mapped = block.mapped == nullptr ? nullptr : static_cast<char*>(block.mapped) + alignedOffset;
+			return true;
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Vk
+{
+	class Device;
+	struct MemoryBlock;
+
+	struct Allocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;
+		MemoryBlock* block = nullptr;
+	};
+
+	//one large VkDeviceMemory that is handed out in aligned ranges
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		VkDeviceSize usedSize;
+		void* mapped;
+		uint32_t memoryType;
+		bool linear;
+		std::map<VkDeviceSize, VkDeviceSize> freeRanges; //offset -> size
+	};
+
+	//buffers and optimal tiling images live in separate blocks so bufferImageGranularity never has to be padded in
+	class Allocator
+	{
+	public:
+		explicit Allocator(const Device& device, VkDeviceSize blockSize = 64 * 1024 * 1024);
+		~Allocator();
+
+		Allocator(const Allocator&) = delete;
+		Allocator& operator=(const Allocator&) = delete;
+
+		Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+		void free(Allocation& allocation);
+		size_t getBlockCount() const;
+		VkDeviceSize getUsedSize() const;
+
+	private:
+		MemoryBlock* createBlock(uint32_t memoryType, bool linear, VkDeviceSize size);
+		void destroyBlock(MemoryBlock* block);
+		bool allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) const;
+
+	private:
+		const Device& device;
+		const VkDeviceSize blockSize;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		uint32_t maxAllocationCount;
+		std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		mutable std::mutex mutex;
+	};
+}
@@ -4,22 +4,22 @@
 
 namespace Vk
 {
-	Buffer::Buffer(const Device& device, const std::vector<Vertex>& vertices, const VkCommandPool commandPool)
-		:device(device), vertexCount(static_cast<uint32_t>(vertices.size())), buffer(VK_NULL_HANDLE),
-		size(sizeof(Vertex) * vertices.size()), bufferMemory(VK_NULL_HANDLE)
+	Buffer::Buffer(const Device& device, const std::vector<Vertex>& vertices)
+		:device(device), vertexCount(static_cast<uint32_t>(vertices.size())), buffer(VK_NULL_HANDLE), uploadToken(0),
+		size(sizeof(Vertex) * vertices.size())
 	{
-		initVertexBuffer(vertices, commandPool);
+		initVertexBuffer(vertices);
 	}
 
-	Buffer::Buffer(const Device& device, const std::vector<uint32_t>& indices, const VkCommandPool commandPool)
-		:device(device), vertexCount(static_cast<uint32_t>(indices.size())), buffer(VK_NULL_HANDLE),
-		size(sizeof(indices[0]) * indices.size()), bufferMemory(VK_NULL_HANDLE)
+	Buffer::Buffer(const Device& device, const std::vector<uint32_t>& indices)
+		:device(device), vertexCount(static_cast<uint32_t>(indices.size())), buffer(VK_NULL_HANDLE), uploadToken(0),
+		size(sizeof(indices[0]) * indices.size())
 	{
-		initIndexBuffer(indices, commandPool);
+		initIndexBuffer(indices);
 	}
 
 	Buffer::Buffer(const Device& device, VkDeviceSize size, VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags memoryProterties)
-		:device(device), vertexCount(0), buffer(VK_NULL_HANDLE), size(size), bufferMemory(VK_NULL_HANDLE)
+		:device(device), vertexCount(0), buffer(VK_NULL_HANDLE), size(size), uploadToken(0)
 	{
 		allocateBuffer(bufferUsage, memoryProterties);
 	}
@@ -28,7 +28,7 @@ namespace Vk
 	Buffer::~Buffer() noexcept
 	{
 		vkDestroyBuffer(device.getLogicalDevice(), buffer, nullptr);
-		vkFreeMemory(device.getLogicalDevice(), bufferMemory, nullptr);
+		device.getAllocator().free(allocation);
 	}
 
 	void Buffer::bind(const VkCommandBuffer commandBuffer) const
@@ -37,17 +37,17 @@ namespace Vk
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
 	}
 
-	void Buffer::copyBuffer(VkBuffer destinationBuffer, const VkCommandPool commandPool) const
+	UploadToken Buffer::copyBuffer(VkBuffer destinationBuffer) const
 	{
-		auto commandBuffer = device.beginCommandBuffer(commandPool);
+		auto& uploadContext = device.getUploadContext();
 
 		VkBufferCopy copyRegion{};
 		copyRegion.srcOffset = 0; 
 		copyRegion.dstOffset = 0;
 		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, buffer, destinationBuffer, 1, &copyRegion);
+		vkCmdCopyBuffer(uploadContext.getCommandBuffer(), buffer, destinationBuffer, 1, &copyRegion);
 
-		device.endCommandBuffer(commandBuffer, commandPool);
+		return uploadContext.getToken();
 	}
 
 	const uint32_t Buffer::getVertexCount() const noexcept
@@ -67,37 +67,40 @@ namespace Vk
 
 	const VkDeviceMemory Buffer::getMemory() const noexcept
 	{
-		return bufferMemory;
+		return allocation.memory;
 	}
 
-	void Buffer::setData(const void* data, size_t size)
+	VkDeviceSize Buffer::getMemoryOffset() const noexcept
 	{
+		return allocation.offset;
+	}
 
-		void* hostMemory;
-		vkMapMemory(device.getLogicalDevice(), bufferMemory, 0, this->size, 0, &hostMemory);
-		memcpy(hostMemory, data, size);
-		vkUnmapMemory(device.getLogicalDevice(), bufferMemory);
+	void* Buffer::getMappedData() const noexcept
+	{
+		return allocation.mapped;
+	}
+
+	UploadToken Buffer::getUploadToken() const noexcept
+	{
+		return uploadToken;
+	}
 
+	void Buffer::setData(const void* data, size_t size)
+	{
+		assert(allocation.mapped != nullptr, "buffer memory is not host visible");
+		memcpy(allocation.mapped, data, size);
 	}
 	
-	void Buffer::initVertexBuffer(const std::vector<Vertex>& vertices, const VkCommandPool commandPool)
+	void Buffer::initVertexBuffer(const std::vector<Vertex>& vertices)
 	{
-		Buffer transferBuffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		transferBuffer.setData(vertices.data(), static_cast<size_t>(size));
-
 		allocateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		transferBuffer.copyBuffer(buffer, commandPool);
+		uploadToken = device.getUploadContext().copyBuffer(vertices.data(), size, buffer);
 	}
 
-	void Buffer::initIndexBuffer(const std::vector<uint32_t>& indices, const VkCommandPool commandPool)
+	void Buffer::initIndexBuffer(const std::vector<uint32_t>& indices)
 	{
-		Buffer transferBuffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		transferBuffer.setData(indices.data(), static_cast<size_t>(size));
-
 		allocateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		transferBuffer.copyBuffer(buffer, commandPool);
+		uploadToken = device.getUploadContext().copyBuffer(indices.data(), size, buffer);
 	}
 
 	void Buffer::allocateBuffer(VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags memoryProperties)
@@ -112,14 +115,9 @@ namespace Vk
 		VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device.getLogicalDevice(), buffer, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = device.getMemoryTypeIdx(memRequirements.memoryTypeBits, memoryProperties);
-
-		assert(vkAllocateMemory(device.getLogicalDevice(), &allocInfo, nullptr, &bufferMemory) == VK_SUCCESS, "cant allocate buffer");
+		allocation = device.getAllocator().allocate(memRequirements, memoryProperties, true);
 
-        vkBindBufferMemory(device.getLogicalDevice(), buffer, bufferMemory, 0);
+        vkBindBufferMemory(device.getLogicalDevice(), buffer, allocation.memory, allocation.offset);
 	}
 
 	std::array<VkVertexInputBindingDescription, 1> Vertex::getBindingDescriptions()
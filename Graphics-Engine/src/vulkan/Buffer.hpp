@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <array>
 #include "Device.hpp"
+#include "Allocator.hpp"
+#include "UploadContext.hpp"
 
 namespace Vk 
 {
@@ -22,8 +24,8 @@ namespace Vk
 	class Buffer
 	{
 	public:
-		explicit Buffer(const Device& device, const std::vector<Vertex>& vertices, const VkCommandPool commandPool);
-		explicit Buffer(const Device& device, const std::vector<uint32_t>& indices, const VkCommandPool commandPool);
+		explicit Buffer(const Device& device, const std::vector<Vertex>& vertices);
+		explicit Buffer(const Device& device, const std::vector<uint32_t>& indices);
 		explicit Buffer(const Device& device, VkDeviceSize size, VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags memoryProperties);
 		~Buffer() noexcept;
 
@@ -32,16 +34,20 @@ namespace Vk
 		Buffer& operator=(const Buffer&) = delete;
 
 		void bind(const VkCommandBuffer commandBuffer) const;
-		void copyBuffer(VkBuffer destinationBuffer, const VkCommandPool commandPool) const;
+		UploadToken copyBuffer(VkBuffer destinationBuffer) const;
 		const uint32_t getVertexCount() const noexcept;
 		VkDeviceSize getDeviceSize() const noexcept;
 		VkBuffer getBuffer() const noexcept;
 		const VkDeviceMemory getMemory() const noexcept;
+		VkDeviceSize getMemoryOffset() const noexcept;
+		void* getMappedData() const noexcept;
+		UploadToken getUploadToken() const noexcept;
 		void setData(const void* data, size_t size);
 
 	private:
-		void initVertexBuffer(const std::vector<Vertex>& vertices, const VkCommandPool commandPool);
-		void initIndexBuffer(const std::vector<uint32_t>& indices, const VkCommandPool commmandPool);
+		void initVertexBuffer(const std::vector<Vertex>& vertices);
+		void initIndexBuffer(const std::vector<uint32_t>& indices);
+		void uploadData(const void* data, const VkCommandPool commandPool);
 		void allocateBuffer(VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags memoryProperties);
 
 	private:
@@ -49,7 +55,8 @@ namespace Vk
 		const uint32_t vertexCount;
 		VkBuffer buffer;
 		VkDeviceSize size;
-		VkDeviceMemory bufferMemory;
+		Allocation allocation;
+		UploadToken uploadToken;
 	};
 }
 
@@ -12,7 +12,10 @@ namespace Vk
 
 	void Camera::update()
 	{
-		viewProjection = glm::perspective(fieldOfView, aspectRatio, near, far) * glm::lookAt(position, target, up);
+		view = glm::lookAt(position, target, up);
+		projection = glm::perspective(fieldOfView, aspectRatio, near, far);
+		viewProjection = projection * view;
+		updateFrustumPlanes();
 	}
 
 	void Camera::move(const glm::vec3& change) noexcept
@@ -25,8 +28,39 @@ namespace Vk
 		target += change;
 	}
 
+	const glm::mat4& Camera::getView() const noexcept
+	{
+		return view;
+	}
+
+	const glm::mat4& Camera::getProjection() const noexcept
+	{
+		return projection;
+	}
+
 	const glm::mat4& Camera::getViewProjection() const  noexcept
 	{
 		return viewProjection;
 	}
+
+	//world space planes facing inside the frustum, xyz is the unit normal and w the distance
+	const std::array<glm::vec4, 6>& Camera::getFrustumPlanes() const noexcept
+	{
+		return frustumPlanes;
+	}
+
+	//rows of the view projection combined, depth is zero to one so the near plane is the third row alone
+	void Camera::updateFrustumPlanes()
+	{
+		const glm::mat4 rows = glm::transpose(viewProjection);
+		frustumPlanes[0] = rows[3] + rows[0];
+		frustumPlanes[1] = rows[3] - rows[0];
+		frustumPlanes[2] = rows[3] + rows[1];
+		frustumPlanes[3] = rows[3] - rows[1];
+		frustumPlanes[4] = rows[2];
+		frustumPlanes[5] = rows[3] - rows[2];
+
+		for (auto& plane : frustumPlanes)
+			plane /= glm::length(glm::vec3(plane));
+	}
 }
@@ -3,6 +3,7 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <array>
 
 namespace Vk
 {
@@ -19,15 +20,22 @@ namespace Vk
 		void update();
 		void move(const glm::vec3& change) noexcept;
 		void moveTarget(const glm::vec3& change) noexcept;
+		const glm::mat4& getView() const noexcept;
+		const glm::mat4& getProjection() const noexcept;
 		const glm::mat4& getViewProjection() const noexcept;
+		const std::array<glm::vec4, 6>& getFrustumPlanes() const noexcept;
 
 	public:
 		glm::vec3 position, target, up;
 
+	private:
+		void updateFrustumPlanes();
+
 	private:
 		#undef near
 		#undef far
 		float aspectRatio, fieldOfView, near, far;
-		glm::mat4 viewProjection;
+		glm::mat4 view, projection, viewProjection;
+		std::array<glm::vec4, 6> frustumPlanes;
 	};
 }
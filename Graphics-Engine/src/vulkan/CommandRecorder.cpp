@@ -0,0 +1,103 @@
+#include <algorithm>
+#include "CommandRecorder.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	CommandRecorder::CommandRecorder(const Device& device, uint32_t maxFramesInFlight, uint32_t threadCount)
+		:device(device), maxFramesInFlight(maxFramesInFlight), threadPool(threadCount)
+	{
+		createCommandPools();
+	}
+
+	CommandRecorder::~CommandRecorder()
+	{
+		for (auto commandPool : commandPools)
+			vkDestroyCommandPool(device.getLogicalDevice(), commandPool, nullptr);
+	}
+
+	//splits itemCount between the workers, each one records its part into its own secondary buffer
+	//returns once every worker finished, the buffers stay valid until the same frame is recorded again
+	const std::vector<VkCommandBuffer>& CommandRecorder::record(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritanceInfo,
+		uint32_t itemCount, const RecordFunction& recordFunction)
+	{
+		recorded.clear();
+		if (itemCount == 0)
+			return recorded;
+
+		const uint32_t threadCount = threadPool.getThreadCount();
+		const uint32_t workerCount = std::clamp((itemCount + minItemsPerWorker - 1) / minItemsPerWorker, 1u, threadCount);
+
+		std::vector<std::future<void>> results;
+		results.reserve(workerCount);
+		for (uint32_t worker = 0; worker < workerCount; ++worker)
+		{
+			const uint32_t index = frame * threadCount + worker;
+			VkCommandBuffer commandBuffer = commandBuffers[index];
+			VkCommandPool commandPool = commandPools[index];
+			recorded.push_back(commandBuffer);
+
+			results.push_back(threadPool.submit([this, commandBuffer, commandPool, worker, workerCount, &inheritanceInfo, &recordFunction]() {
+				vkResetCommandPool(device.getLogicalDevice(), commandPool, 0);
+
+				VkCommandBufferBeginInfo beginInfo{};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				//the buffers of a frame are executed by the cached primary buffers of every swap chain image
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+				beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+				assert(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS, "cant start secondary command buffer");
+				recordFunction(commandBuffer, worker, workerCount);
+				assert(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "cant end secondary command buffer");
+			}));
+		}
+
+		//every task references the arguments, so all of them have to finish before an error is rethrown
+		for (auto& result : results)
+			result.wait();
+		for (auto& result : results)
+			result.get();
+
+		return recorded;
+	}
+
+	uint32_t CommandRecorder::getThreadCount() const noexcept
+	{
+		return threadPool.getThreadCount();
+	}
+
+	//first item and item count of one worker, the parts differ by one item at most
+	std::pair<uint32_t, uint32_t> CommandRecorder::getRange(uint32_t itemCount, uint32_t worker, uint32_t workerCount) noexcept
+	{
+		const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * worker / workerCount);
+		const uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * (worker + 1) / workerCount);
+		return { first, last - first };
+	}
+
+	//one pool with a single secondary buffer for every worker and frame in flight
+	void CommandRecorder::createCommandPools()
+	{
+		QueueFamilyIndices queueFamilyIndices = device.getQueueFamilies(device.getPhysicalDevice());
+		const uint32_t poolCount = maxFramesInFlight * threadPool.getThreadCount();
+		commandPools.resize(poolCount);
+		commandBuffers.resize(poolCount);
+
+		for (uint32_t i = 0; i < poolCount; ++i)
+		{
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = 0; //the buffers are kept and executed again while the scene is unchanged, so they are not transient
+			poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+			assert(vkCreateCommandPool(device.getLogicalDevice(), &poolInfo, nullptr, &commandPools[i]) == VK_SUCCESS, "cant create command pool");
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = commandPools[i];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			assert(vkAllocateCommandBuffers(device.getLogicalDevice(), &allocInfo, &commandBuffers[i]) == VK_SUCCESS, "cant allocate command buffer");
+		}
+	}
+}
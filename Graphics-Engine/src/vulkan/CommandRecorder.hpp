@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <functional>
+#include "Device.hpp"
+#include "../utils/ThreadPool.hpp"
+
+namespace Vk
+{
+	//records secondary command buffers on worker threads, the primary buffer only executes them
+	//command pools cant be used from two threads at once, so every worker has its own pool for every frame in flight
+	//a pool is reset as a whole when its frame is recorded again, after the fence of that frame has signaled
+	class CommandRecorder
+	{
+	public:
+		//smaller lists are not worth waking another thread for
+		static constexpr uint32_t minItemsPerWorker = 512;
+
+		//worker, worker count
+		using RecordFunction = std::function<void(VkCommandBuffer, uint32_t, uint32_t)>;
+
+		explicit CommandRecorder(const Device& device, uint32_t maxFramesInFlight, uint32_t threadCount = 0);
+		~CommandRecorder();
+
+		CommandRecorder(const CommandRecorder&) = delete;
+		CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+		const std::vector<VkCommandBuffer>& record(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritanceInfo,
+			uint32_t itemCount, const RecordFunction& recordFunction);
+		uint32_t getThreadCount() const noexcept;
+
+		static std::pair<uint32_t, uint32_t> getRange(uint32_t itemCount, uint32_t worker, uint32_t workerCount) noexcept;
+
+	private:
+		void createCommandPools();
+
+	private:
+		const Device& device;
+		const uint32_t maxFramesInFlight;
+		ThreadPool threadPool;
+		std::vector<VkCommandPool> commandPools; //frame * thread count + worker
+		std::vector<VkCommandBuffer> commandBuffers;
+		std::vector<VkCommandBuffer> recorded;
+	};
+}
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include "CpuCuller.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define CULL_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define CULL_TARGET_AVX2
+	#else
+		#define CULL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#endif
+#endif
+
+namespace
+{
+	using Vk::BoundingSpheres;
+	using Planes = std::array<glm::vec4, 6>;
+
+	bool isVisible(const Planes& planes, float x, float y, float z, float radius) noexcept
+	{
+		for (const auto& plane : planes)
+		{
+			if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t cullScalar(const Planes& planes, const BoundingSpheres& spheres, size_t first, uint32_t* visible) noexcept
+	{
+		uint32_t count = 0;
+		for (size_t i = first; i < spheres.size(); ++i)
+		{
+			if (isVisible(planes, spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]))
+				visible[count++] = static_cast<uint32_t>(i);
+		}
+		return count;
+	}
+
+#ifdef CULL_X86
+	//one bit per lane of the visibility mask, lowest bit is the first sphere
+	uint32_t appendVisible(uint32_t mask, uint32_t first, uint32_t* visible) noexcept
+	{
+		uint32_t count = 0;
+		while (mask)
+		{
+			#if defined(_MSC_VER)
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+			#else
+				uint32_t bit = static_cast<uint32_t>(__builtin_ctz(mask));
+			#endif
+			visible[count++] = first + static_cast<uint32_t>(bit);
+			mask &= mask - 1;
+		}
+		return count;
+	}
+
+	uint32_t cullSse(const Planes& planes, const BoundingSpheres& spheres, uint32_t* visible) noexcept
+	{
+		const size_t count = spheres.size() & ~size_t(3);
+		uint32_t visibleCount = 0;
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(&spheres.x[i]);
+			__m128 y = _mm_loadu_ps(&spheres.y[i]);
+			__m128 z = _mm_loadu_ps(&spheres.z[i]);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const auto& plane : planes)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+				distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+			}
+
+			visibleCount += appendVisible(static_cast<uint32_t>(_mm_movemask_ps(inside)), static_cast<uint32_t>(i), visible + visibleCount);
+		}
+
+		return visibleCount + cullScalar(planes, spheres, count, visible + visibleCount);
+	}
+
+	CULL_TARGET_AVX2 uint32_t cullAvx2(const Planes& planes, const BoundingSpheres& spheres, uint32_t* visible) noexcept
+	{
+		const size_t count = spheres.size() & ~size_t(7);
+		uint32_t visibleCount = 0;
+
+		for (size_t i = 0; i < count; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(&spheres.x[i]);
+			__m256 y = _mm256_loadu_ps(&spheres.y[i]);
+			__m256 z = _mm256_loadu_ps(&spheres.z[i]);
+			__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const auto& plane : planes)
+			{
+				__m256 distance = _mm256_fmadd_ps(x, _mm256_set1_ps(plane.x), _mm256_set1_ps(plane.w));
+				distance = _mm256_fmadd_ps(y, _mm256_set1_ps(plane.y), distance);
+				distance = _mm256_fmadd_ps(z, _mm256_set1_ps(plane.z), distance);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+			}
+
+			visibleCount += appendVisible(static_cast<uint32_t>(_mm256_movemask_ps(inside)), static_cast<uint32_t>(i), visible + visibleCount);
+		}
+
+		return visibleCount + cullScalar(planes, spheres, count, visible + visibleCount);
+	}
+
+	bool hasAvx2() noexcept
+	{
+		#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+
+			__cpuid(info, 1);
+			const bool fma = info[2] & (1 << 12);
+			const bool osxsave = info[2] & (1 << 27);
+			const bool avx = info[2] & (1 << 28);
+			if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+				return false;
+
+			__cpuidex(info, 7, 0);
+			return info[1] & (1 << 5);
+		#else
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		#endif
+	}
+#endif
+}
+
+namespace Vk
+{
+	void BoundingSpheres::add(const glm::vec4& sphere)
+	{
+		x.push_back(sphere.x);
+		y.push_back(sphere.y);
+		z.push_back(sphere.z);
+		radius.push_back(sphere.w);
+	}
+
+	void BoundingSpheres::reserve(size_t count)
+	{
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+		radius.reserve(count);
+	}
+
+	void BoundingSpheres::clear() noexcept
+	{
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	size_t BoundingSpheres::size() const noexcept
+	{
+		return x.size();
+	}
+
+	//an unsupported kernel falls back to the best one that is
+	CpuCuller::CpuCuller(CullKernel kernel)
+		:kernel(isKernelSupported(kernel) ? kernel : getBestKernel())
+	{
+
+	}
+
+	//planes face inside, a sphere is culled once it is fully behind any of them
+	uint32_t CpuCuller::cull(const std::array<glm::vec4, 6>& planes, const BoundingSpheres& spheres, std::vector<uint32_t>& visible) const
+	{
+		visible.resize(spheres.size());
+		uint32_t count = 0;
+
+		switch (kernel)
+		{
+		#ifdef CULL_X86
+		case CullKernel::Avx2:
+			count = cullAvx2(planes, spheres, visible.data());
+			break;
+		case CullKernel::Sse:
+			count = cullSse(planes, spheres, visible.data());
+			break;
+		#endif
+		default:
+			count = cullScalar(planes, spheres, 0, visible.data());
+			break;
+		}
+
+		visible.resize(count);
+		return count;
+	}
+
+	CullKernel CpuCuller::getKernel() const noexcept
+	{
+		return kernel;
+	}
+
+	CullKernel CpuCuller::getBestKernel()
+	{
+		if (isKernelSupported(CullKernel::Avx2))
+			return CullKernel::Avx2;
+		if (isKernelSupported(CullKernel::Sse))
+			return CullKernel::Sse;
+		return CullKernel::Scalar;
+	}
+
+	//sse2 is part of every x86 target msvc builds for
+	bool CpuCuller::isKernelSupported(CullKernel kernel)
+	{
+		#ifdef CULL_X86
+			static const bool avx2 = hasAvx2();
+			return kernel != CullKernel::Avx2 || avx2;
+		#else
+			return kernel == CullKernel::Scalar;
+		#endif
+	}
+
+	const char* CpuCuller::getKernelName(CullKernel kernel) noexcept
+	{
+		switch (kernel)
+		{
+		case CullKernel::Avx2:
+			return "avx2";
+		case CullKernel::Sse:
+			return "sse";
+		default:
+			return "scalar";
+		}
+	}
+
+	//radius grows with the largest axis scale so the sphere still holds the mesh
+	glm::vec4 CpuCuller::transformSphere(const glm::vec4& sphere, const glm::mat4& model) noexcept
+	{
+		glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+		float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+		return glm::vec4(center, sphere.w * scale);
+	}
+}
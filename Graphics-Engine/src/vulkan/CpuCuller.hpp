@@ -0,0 +1,48 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace Vk
+{
+	//world space spheres as structure of arrays so a kernel loads four or eight of them with one instruction
+	struct BoundingSpheres
+	{
+		std::vector<float> x, y, z, radius;
+
+		void add(const glm::vec4& sphere);
+		void reserve(size_t count);
+		void clear() noexcept;
+		size_t size() const noexcept;
+	};
+
+	enum class CullKernel
+	{
+		Scalar,
+		Sse,
+		Avx2
+	};
+
+	//cpu alternative to the FrustumCuller compute pass, tests every sphere against the six frustum planes
+	//and writes the indices of the visible ones, the widest kernel the cpu supports is picked by default
+	class CpuCuller
+	{
+	public:
+		explicit CpuCuller(CullKernel kernel = getBestKernel());
+
+		uint32_t cull(const std::array<glm::vec4, 6>& planes, const BoundingSpheres& spheres, std::vector<uint32_t>& visible) const;
+		CullKernel getKernel() const noexcept;
+
+		static CullKernel getBestKernel();
+		static bool isKernelSupported(CullKernel kernel);
+		static const char* getKernelName(CullKernel kernel) noexcept;
+		static glm::vec4 transformSphere(const glm::vec4& sphere, const glm::mat4& model) noexcept;
+
+	private:
+		CullKernel kernel;
+	};
+}
@@ -1,4 +1,5 @@
 #include <array>
+#include <numeric>
 #include "Cube.hpp"
 #include "Pipeline.hpp"
 #include "../utils/Logger.hpp"
@@ -6,40 +7,26 @@
 
 namespace Vk
 {
-	Cube::Cube(const Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, 
-		const VkCommandPool commandPool)
-		:Renderable(device, vertices, indices, commandPool)
+	Cube::Cube(const Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		:Renderable(device, vertices, indices)
 	{
 	}
 
-	Cube::~Cube() noexcept
+	//shares the geometry of prototype so both end up in one instanced draw
+	Cube::Cube(const Cube& prototype, const glm::vec3& position)
+		:Renderable(prototype.mesh), dimensions(prototype.dimensions), color(prototype.color)
 	{
-
+		transform = prototype.transform;
+		pipelineState = prototype.pipelineState;
+		transform.position = position;
 	}
 
-	void Cube::draw(VkCommandBuffer commandBuffer, const VkPipelineLayout pipelineLayout, const Camera& camera) const 
+	Cube::~Cube() noexcept
 	{
-		VkBuffer rawVertexBuffer = vertexBuffer->getBuffer();
-		VkDeviceSize offset = 0;
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &rawVertexBuffer, &offset);
 
-		//vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-		PushConstant push{};
-		push.model = transform.getModel();
-		push.viewProjection = camera.getViewProjection();
-		//static unsigned long long ctr = 0;
-		//push.model = glm::rotate(push.model, glm::radians(.05f * ctr++), glm::vec3{ 0, 1, 0 });
-		//push.model = glm::rotate(push.model, glm::radians(.01f * ctr++), glm::vec3{ 1, 0, 0 });
-		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstant), &push);
-
-        //vkCmdDrawIndexed(commandBuffer, indexBuffer->getVertexCount(), 1, 0, 0, 0);
-		vkCmdDraw(commandBuffer, vertexBuffer->getVertexCount(), 1, 0, 0);
-		//transform.rotation.x += 0.0005f;
-		//transform.rotation.y = glm::mod(transform.rotation.y + 0.001f, glm::two_pi<float>());
-		//transform.rotation.z = glm::mod(transform.rotation.z + 0.0005f, glm::two_pi<float>());
 	}
 
-	Cube Cube::createCube(const Device& device, const glm::vec3& dimensions, const glm::vec3& position, const glm::vec3& color, const VkCommandPool commandPool)
+	Cube Cube::createCube(const Device& device, const glm::vec3& dimensions, const glm::vec3& position, const glm::vec3& color)
 	{
 		std::vector<Vertex> vertices(8);
 		std::vector<uint32_t> indices(36);
@@ -151,7 +138,11 @@ namespace Vk
 		//std::vector<Vertex>* vtemp = new std::vector<Vertex>(vertices.begin(), vertices.begin() + 4);
 		//std::vector<uint32_t>* itemp = new std::vector<uint32_t>(indices.begin(), indices.begin() + 6);
 	
-		Cube rectangle(device, _vertices, indices, commandPool);
+		//the face list is unindexed, every mesh is drawn indexed from the shared geometry buffer
+		std::vector<uint32_t> _indices(_vertices.size());
+		std::iota(_indices.begin(), _indices.end(), 0);
+
+		Cube rectangle(device, _vertices, _indices);
 		rectangle.transform.position = position;
 		rectangle.dimensions = dimensions;
 		rectangle.color = color;
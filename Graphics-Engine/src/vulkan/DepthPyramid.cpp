@@ -0,0 +1,350 @@
+#include <array>
+#include <algorithm>
+#include "DepthPyramid.hpp"
+#include "Shader.hpp"
+#include "LayoutCache.hpp"
+#include "PipelineCache.hpp"
+#include "../utils/assert.hpp"
+#include "../utils/Logger.hpp"
+
+namespace
+{
+	struct PyramidPushConstant
+	{
+		int32_t sourceWidth, sourceHeight;
+		int32_t destinationWidth, destinationHeight;
+	};
+
+	uint32_t previousPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result * 2 <= value)
+			result *= 2;
+		return result;
+	}
+}
+
+namespace Vk
+{
+	DepthPyramid::DepthPyramid(const Device& device, const SwapChain& swapChain)
+		:device(device), swapChain(swapChain), image(VK_NULL_HANDLE), view(VK_NULL_HANDLE), extent{ 0, 0 }, levelCount(0),
+		sampler(VK_NULL_HANDLE), descriptorLayout(VK_NULL_HANDLE), descriptorPool(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE),
+		pipeline(VK_NULL_HANDLE), prepared(false), valid(false)
+	{
+		createSampler();
+		createPipeline();
+		createImage();
+		createDescriptorSets();
+	}
+
+	DepthPyramid::~DepthPyramid()
+	{
+		destroyImage();
+		vkDestroyPipeline(device.getLogicalDevice(), pipeline, nullptr);
+		vkDestroySampler(device.getLogicalDevice(), sampler, nullptr);
+	}
+
+	//pyramid.spv was hot reloaded, returns the replaced pipeline which frames in flight may still run
+	//the layouts stay since a reload cant change the shader interface
+	VkPipeline DepthPyramid::reloadPipeline()
+	{
+		VkPipeline replaced = pipeline;
+		createPipeline();
+		return replaced;
+	}
+
+	//the swap chain was recreated, the device is idle so nothing still reads the old pyramid
+	void DepthPyramid::recreate()
+	{
+		destroyImage();
+		createImage();
+		createDescriptorSets();
+		prepared = false;
+		valid = false;
+	}
+
+	//moves a new pyramid to the general layout it stays in, before anything binds it
+	//returns whether the transition was recorded, a command buffer holding it must not be submitted twice
+	bool DepthPyramid::prepare(VkCommandBuffer commandBuffer)
+	{
+		if (prepared)
+			return false;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = levelCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+		prepared = true;
+		return true;
+	}
+
+	//recorded after the render pass, its outgoing dependency already made the depth writes visible to compute
+	void DepthPyramid::build(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		//this frame's culling pass read the pyramid, it can be overwritten once that is done
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = levelCount;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+		VkExtent2D depthExtent = swapChain.getExtent();
+		PyramidPushConstant push{};
+		push.sourceWidth = static_cast<int32_t>(depthExtent.width);
+		push.sourceHeight = static_cast<int32_t>(depthExtent.height);
+
+		barrier.subresourceRange.levelCount = 1;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			push.destinationWidth = static_cast<int32_t>(std::max(extent.width >> level, 1u));
+			push.destinationHeight = static_cast<int32_t>(std::max(extent.height >> level, 1u));
+
+			VkDescriptorSet set = level == 0 ? depthSets[imageIndex] : levelSets[level - 1];
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidPushConstant), &push);
+			vkCmdDispatch(commandBuffer, (push.destinationWidth + groupSize - 1) / groupSize, (push.destinationHeight + groupSize - 1) / groupSize, 1);
+
+			//the next level reads this one, the next frame's culling pass reads all of them
+			barrier.subresourceRange.baseMipLevel = level;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			push.sourceWidth = push.destinationWidth;
+			push.sourceHeight = push.destinationHeight;
+		}
+
+		valid = true;
+	}
+
+	//false until the first build, culling against it before that would hide everything at random
+	bool DepthPyramid::isValid() const noexcept
+	{
+		return valid;
+	}
+
+	VkImageView DepthPyramid::getView() const noexcept
+	{
+		return view;
+	}
+
+	VkSampler DepthPyramid::getSampler() const noexcept
+	{
+		return sampler;
+	}
+
+	VkExtent2D DepthPyramid::getExtent() const noexcept
+	{
+		return extent;
+	}
+
+	uint32_t DepthPyramid::getLevelCount() const noexcept
+	{
+		return levelCount;
+	}
+
+	void DepthPyramid::createImage()
+	{
+		VkExtent2D depthExtent = swapChain.getExtent();
+		extent.width = previousPowerOfTwo(std::max(depthExtent.width, 1u));
+		extent.height = previousPowerOfTwo(std::max(depthExtent.height, 1u));
+
+		levelCount = 1;
+		while ((std::max(extent.width, extent.height) >> levelCount) > 0)
+			++levelCount;
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = extent.width;
+		imageInfo.extent.height = extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		assert(vkCreateImage(device.getLogicalDevice(), &imageInfo, nullptr, &image) == VK_SUCCESS, "cant create depth pyramid");
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device.getLogicalDevice(), image, &memoryRequirements);
+		imageMemory = device.getAllocator().allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+		vkBindImageMemory(device.getLogicalDevice(), image, imageMemory.memory, imageMemory.offset);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = levelCount;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		assert(vkCreateImageView(device.getLogicalDevice(), &viewInfo, nullptr, &view) == VK_SUCCESS, "cant create depth pyramid view");
+
+		levelViews.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			viewInfo.subresourceRange.baseMipLevel = level;
+			viewInfo.subresourceRange.levelCount = 1;
+			assert(vkCreateImageView(device.getLogicalDevice(), &viewInfo, nullptr, &levelViews[level]) == VK_SUCCESS, "cant create depth pyramid view");
+		}
+
+		LOG_INFO("depth pyramid " + STR(extent.width) + "x" + STR(extent.height) + ", " + STR(levelCount) + " levels");
+	}
+
+	void DepthPyramid::createDescriptorSets()
+	{
+		const uint32_t depthImageCount = static_cast<uint32_t>(swapChain.getDepthImageViews().size());
+		const uint32_t setCount = depthImageCount + levelCount - 1;
+
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[0].descriptorCount = setCount;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[1].descriptorCount = setCount;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = setCount;
+
+		assert(vkCreateDescriptorPool(device.getLogicalDevice(), &poolInfo, nullptr, &descriptorPool) == VK_SUCCESS, "cant create depth pyramid descriptor pool");
+
+		std::vector<VkDescriptorSetLayout> layouts(setCount, descriptorLayout);
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = setCount;
+		allocInfo.pSetLayouts = layouts.data();
+
+		std::vector<VkDescriptorSet> sets(setCount);
+		assert(vkAllocateDescriptorSets(device.getLogicalDevice(), &allocInfo, sets.data()) == VK_SUCCESS, "cant allocate depth pyramid descriptor sets");
+		depthSets.assign(sets.begin(), sets.begin() + depthImageCount);
+		levelSets.assign(sets.begin() + depthImageCount, sets.end());
+
+		auto writeSet = [&](VkDescriptorSet set, VkImageView source, VkImageLayout sourceLayout, VkImageView destination)
+		{
+			VkDescriptorImageInfo sourceInfo{};
+			sourceInfo.sampler = sampler;
+			sourceInfo.imageView = source;
+			sourceInfo.imageLayout = sourceLayout;
+
+			VkDescriptorImageInfo destinationInfo{};
+			destinationInfo.imageView = destination;
+			destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[0].dstSet = set;
+			descriptorWrites[0].dstBinding = 0;
+			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			descriptorWrites[0].descriptorCount = 1;
+			descriptorWrites[0].pImageInfo = &sourceInfo;
+
+			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[1].dstSet = set;
+			descriptorWrites[1].dstBinding = 1;
+			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			descriptorWrites[1].descriptorCount = 1;
+			descriptorWrites[1].pImageInfo = &destinationInfo;
+
+			vkUpdateDescriptorSets(device.getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+		};
+
+		const auto& depthViews = swapChain.getDepthImageViews();
+		for (uint32_t i = 0; i < depthImageCount; ++i)
+			writeSet(depthSets[i], depthViews[i], VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, levelViews[0]);
+		for (uint32_t level = 1; level < levelCount; ++level)
+			writeSet(levelSets[level - 1], levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL, levelViews[level]);
+	}
+
+	void DepthPyramid::createSampler()
+	{
+		//texels are fetched, the sampler only has to exist for the combined descriptors
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		assert(vkCreateSampler(device.getLogicalDevice(), &samplerInfo, nullptr, &sampler) == VK_SUCCESS, "cant create depth pyramid sampler");
+	}
+
+	void DepthPyramid::createPipeline()
+	{
+		//source and destination level, the layouts come from the shader and the layout cache owns them
+		Vk::Shader pyramidShader(device.getLogicalDevice(), "pyramid.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		const ShaderReflection& reflection = pyramidShader.getReflection();
+		assert(reflection.pushConstants.size() == 1 && reflection.pushConstants[0].size == sizeof(PyramidPushConstant), "depth pyramid push constant differs from the shader");
+
+		LayoutCache& layoutCache = device.getLayoutCache();
+		descriptorLayout = layoutCache.getSetLayout(reflection, 0);
+		pipelineLayout = layoutCache.getPipelineLayout(reflection);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = pyramidShader.getCreateInfo();
+		pipelineInfo.layout = pipelineLayout;
+
+		assert(vkCreateComputePipelines(device.getLogicalDevice(), device.getPipelineCache().getCache(), 1, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS, "cant create depth pyramid pipeline");
+	}
+
+	void DepthPyramid::destroyImage()
+	{
+		vkDestroyDescriptorPool(device.getLogicalDevice(), descriptorPool, nullptr);
+		for (auto levelView : levelViews)
+			vkDestroyImageView(device.getLogicalDevice(), levelView, nullptr);
+		vkDestroyImageView(device.getLogicalDevice(), view, nullptr);
+		vkDestroyImage(device.getLogicalDevice(), image, nullptr);
+		device.getAllocator().free(imageMemory);
+
+		levelViews.clear();
+		depthSets.clear();
+		levelSets.clear();
+		descriptorPool = VK_NULL_HANDLE;
+		view = VK_NULL_HANDLE;
+		image = VK_NULL_HANDLE;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "Device.hpp"
+#include "SwapChain.hpp"
+#include "Allocator.hpp"
+
+namespace Vk
+{
+	//mip chain of the depth buffer where every texel holds the farthest depth of the texels below it
+	//built after the render pass, so the culling pass of the next frame tests against the previous frame's depth
+	//the size is the depth extent rounded down to a power of two so every level halves exactly
+	class DepthPyramid
+	{
+	public:
+		static constexpr uint32_t groupSize = 16;
+
+		explicit DepthPyramid(const Device& device, const SwapChain& swapChain);
+		~DepthPyramid();
+
+		DepthPyramid(const DepthPyramid&) = delete;
+		DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+		void recreate();
+		VkPipeline reloadPipeline();
+		bool prepare(VkCommandBuffer commandBuffer);
+		void build(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		bool isValid() const noexcept;
+		VkImageView getView() const noexcept;
+		VkSampler getSampler() const noexcept;
+		VkExtent2D getExtent() const noexcept;
+		uint32_t getLevelCount() const noexcept;
+
+	private:
+		void createImage();
+		void createDescriptorSets();
+		void createSampler();
+		void createPipeline();
+		void destroyImage();
+
+	private:
+		const Device& device;
+		const SwapChain& swapChain;
+		VkImage image;
+		Allocation imageMemory;
+		VkImageView view;
+		std::vector<VkImageView> levelViews;
+		VkExtent2D extent;
+		uint32_t levelCount;
+		VkSampler sampler;
+		VkDescriptorSetLayout descriptorLayout;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> depthSets; //one per swap chain depth image, they feed level 0
+		std::vector<VkDescriptorSet> levelSets; //level i - 1 into level i
+		VkPipelineLayout pipelineLayout;
+		VkPipeline pipeline;
+		bool prepared, valid;
+	};
+}
@@ -3,6 +3,13 @@
 #include <set>
 #include <cstring>
 #include "Device.hpp"
+#include "Allocator.hpp"
+#include "StagingRing.hpp"
+#include "UploadContext.hpp"
+#include "TextureTable.hpp"
+#include "GeometryBuffer.hpp"
+#include "PipelineCache.hpp"
+#include "LayoutCache.hpp"
 #include "../utils/Logger.hpp"
 #include "SwapChain.hpp"
 #include "../utils/assert.hpp"
@@ -12,7 +19,7 @@ namespace Vk
 
 	Device::Device(const VkInstance instance, const Window& window)
 		:instance(instance), surface(VK_NULL_HANDLE), physicalDevice(VK_NULL_HANDLE), device(VK_NULL_HANDLE),
-		graphicsQueue(VK_NULL_HANDLE), presentQueue(VK_NULL_HANDLE)
+		graphicsQueue(VK_NULL_HANDLE), presentQueue(VK_NULL_HANDLE), transferQueue(VK_NULL_HANDLE)
 	{
 		deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 		init(window);
@@ -20,6 +27,13 @@ namespace Vk
 
 	Device::~Device()
 	{
+		layoutCache.reset();
+		pipelineCache.reset();
+		geometryBuffer.reset();
+		textureTable.reset();
+		uploadContext.reset();
+		stagingRing.reset();
+		allocator.reset();
 		vkDestroySurfaceKHR(instance, surface, nullptr);
 		vkDestroyDevice(device, nullptr);
 	}
@@ -39,11 +53,53 @@ namespace Vk
 		return surface;
 	}
 
+	Allocator& Device::getAllocator() const noexcept
+	{
+		return *allocator;
+	}
+
+	StagingRing& Device::getStagingRing() const noexcept
+	{
+		return *stagingRing;
+	}
+
+	UploadContext& Device::getUploadContext() const noexcept
+	{
+		return *uploadContext;
+	}
+
+	TextureTable& Device::getTextureTable() const noexcept
+	{
+		return *textureTable;
+	}
+
+	GeometryBuffer& Device::getGeometryBuffer() const noexcept
+	{
+		return *geometryBuffer;
+	}
+
+	PipelineCache& Device::getPipelineCache() const noexcept
+	{
+		return *pipelineCache;
+	}
+
+	LayoutCache& Device::getLayoutCache() const noexcept
+	{
+		return *layoutCache;
+	}
+
 	void Device::init(const Window& window)
 	{
 		createSurface(window);
 		pickPhysicalDevice();
 		createLogicalDevice();
+		allocator = std::make_unique<Allocator>(*this);
+		stagingRing = std::make_unique<StagingRing>(*this);
+		uploadContext = std::make_unique<UploadContext>(*this, *stagingRing);
+		textureTable = std::make_unique<TextureTable>(*this);
+		geometryBuffer = std::make_unique<GeometryBuffer>(*this);
+		pipelineCache = std::make_unique<PipelineCache>(*this);
+		layoutCache = std::make_unique<LayoutCache>(*this);
 	}
 
 	void Device::pickPhysicalDevice()
@@ -87,6 +143,10 @@ namespace Vk
 			return 0;
 		if (!checkDeviceExtensionSupport(physicalDevice) || !deviceFeatures.samplerAnisotropy)
 			return 0;
+		if (!deviceFeatures.multiDrawIndirect || !deviceFeatures.drawIndirectFirstInstance)
+			return 0;
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_2 || !checkDescriptorIndexingSupport(physicalDevice))
+			return 0;
 
 		auto swapChainSupport = SwapChain::querySwapChainSupport(physicalDevice, surface);
 		if (swapChainSupport.formats.empty() || swapChainSupport.presentModes.empty())
@@ -112,6 +172,18 @@ namespace Vk
 		vkGetPhysicalDeviceQueueFamilyProperties(deviceToRate, &queueFamilyCount, queueFamilies.data());
 
 		QueueFamilyIndices indices;
+
+		//a family with transfer but no graphics or compute is usually a dedicated dma engine
+		for (uint32_t i = 0; i < queueFamilies.size(); ++i)
+		{
+			VkQueueFlags flags = queueFamilies[i].queueFlags;
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				indices.transferFamily = i;
+				break;
+			}
+		}
+
 		for (uint32_t i = 0; i < queueFamilies.size(); ++i)
 		{
 			if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
@@ -143,6 +215,16 @@ namespace Vk
 		return presentQueue;
 	}
 
+	VkQueue Device::getTransferQueue() const
+	{
+		return transferQueue;
+	}
+
+	bool Device::hasTransferQueue() const noexcept
+	{
+		return transferQueue != graphicsQueue;
+	}
+
 	VkFormat Device::getSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const
 	{
 		for (VkFormat format : candidates) 
@@ -179,46 +261,14 @@ namespace Vk
 		assert(false, "cant find required memory type");
 	}
 
-	VkCommandBuffer Device::beginCommandBuffer(const VkCommandPool commandPool) const
-	{
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
-
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		return commandBuffer;
-	}
-
-	void Device::endCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandPool commandPool) const
-	{
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, nullptr);
-		vkQueueWaitIdle(graphicsQueue);
-
-		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-	}
-
 	void Device::createLogicalDevice()
 	{
 		auto indices = getQueueFamilies(physicalDevice);
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		if (indices.transferFamily.has_value())
+			uniqueQueueFamilies.insert(indices.transferFamily.value());
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -230,14 +280,28 @@ namespace Vk
 			queueCreateInfos.push_back(std::move(queueCreateInfo));
 		}
 
-		VkPhysicalDeviceFeatures deviceFeatures{};
-		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		//what the bindless texture table needs
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+
+		VkPhysicalDeviceFeatures2 deviceFeatures{};
+		deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures.pNext = &indexingFeatures;
+		deviceFeatures.features.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.features.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.features.drawIndirectFirstInstance = VK_TRUE;
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = &deviceFeatures;
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
-		createInfo.pEnabledFeatures = &deviceFeatures;
+		createInfo.pEnabledFeatures = nullptr;
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -245,6 +309,11 @@ namespace Vk
 
 		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+
+		if (indices.transferFamily.has_value())
+			vkGetDeviceQueue(device, indices.transferFamily.value(), 0, &transferQueue);
+		else
+			transferQueue = graphicsQueue;
 	}
 
 	void Device::createSurface(const Window& window)
@@ -285,4 +354,19 @@ namespace Vk
 	{
 		return graphicsFamily.has_value() && presentFamily.has_value();
 	}
+
+	bool Device::checkDescriptorIndexingSupport(VkPhysicalDevice device) const
+	{
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &indexingFeatures;
+		vkGetPhysicalDeviceFeatures2(device, &features);
+
+		return indexingFeatures.shaderSampledImageArrayNonUniformIndexing && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+			indexingFeatures.descriptorBindingUpdateUnusedWhilePending && indexingFeatures.descriptorBindingPartiallyBound &&
+			indexingFeatures.runtimeDescriptorArray;
+	}
 }
\ No newline at end of file
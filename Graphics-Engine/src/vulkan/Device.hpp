@@ -2,15 +2,24 @@
 
 #include <optional>
 #include <vector>
+#include <memory>
 #include "../Window.hpp"
 
 namespace Vk 
 {
+	class Allocator;
+	class StagingRing;
+	class UploadContext;
+	class TextureTable;
+	class GeometryBuffer;
+	class PipelineCache;
+	class LayoutCache;
 
 	struct QueueFamilyIndices
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily;
 
 		bool hasValues() const;
 	};
@@ -30,10 +39,17 @@ namespace Vk
 		QueueFamilyIndices getQueueFamilies(VkPhysicalDevice deviceToRate) const;
 		VkQueue getGraphicsQueue() const;
 		VkQueue getPresentQueue() const;
+		VkQueue getTransferQueue() const;
+		bool hasTransferQueue() const noexcept;
 		VkFormat getSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const;
 		uint32_t getMemoryTypeIdx(VkFlags requiredTypes, VkMemoryPropertyFlags properties) const;
-		VkCommandBuffer beginCommandBuffer(const VkCommandPool commandPool) const;
-		void endCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandPool commandPool) const;
+		Allocator& getAllocator() const noexcept;
+		StagingRing& getStagingRing() const noexcept;
+		UploadContext& getUploadContext() const noexcept;
+		TextureTable& getTextureTable() const noexcept;
+		GeometryBuffer& getGeometryBuffer() const noexcept;
+		PipelineCache& getPipelineCache() const noexcept;
+		LayoutCache& getLayoutCache() const noexcept;
 
 	private:
 		void init(const Window& window);
@@ -42,13 +58,21 @@ namespace Vk
 		void createSurface(const Window& window);
 		uint32_t ratePhysicalDevice(VkPhysicalDevice device) const;
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device) const;
+		bool checkDescriptorIndexingSupport(VkPhysicalDevice device) const;
 
 	private:
 		const VkInstance instance;
 		VkSurfaceKHR surface;
 		VkPhysicalDevice physicalDevice;
 		VkDevice device;
-		VkQueue graphicsQueue, presentQueue;
+		VkQueue graphicsQueue, presentQueue, transferQueue;
 		std::vector<const char*> deviceExtensions;
+		std::unique_ptr<Allocator> allocator;
+		std::unique_ptr<StagingRing> stagingRing;
+		std::unique_ptr<UploadContext> uploadContext;
+		std::unique_ptr<TextureTable> textureTable;
+		std::unique_ptr<GeometryBuffer> geometryBuffer;
+		std::unique_ptr<PipelineCache> pipelineCache;
+		std::unique_ptr<LayoutCache> layoutCache;
 	};
 }
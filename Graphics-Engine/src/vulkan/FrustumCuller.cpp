@@ -0,0 +1,214 @@
+#include <array>
+#include <algorithm>
+#include "FrustumCuller.hpp"
+#include "Shader.hpp"
+#include "PipelineCache.hpp"
+#include "LayoutCache.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	FrustumCuller::FrustumCuller(const Device& device, uint32_t maxFramesInFlight)
+		:device(device), maxFramesInFlight(maxFramesInFlight), descriptorLayout(VK_NULL_HANDLE), descriptorPool(VK_NULL_HANDLE),
+		pipelineLayout(VK_NULL_HANDLE), pipeline(VK_NULL_HANDLE), previousViewProjection(1.0f)
+	{
+		createPipeline();
+		createDescriptorSets();
+		createFrameBuffers();
+	}
+
+	FrustumCuller::~FrustumCuller()
+	{
+		vkDestroyPipeline(device.getLogicalDevice(), pipeline, nullptr);
+		vkDestroyDescriptorPool(device.getLogicalDevice(), descriptorPool, nullptr);
+	}
+
+	//called whenever one of the frame's buffers is reallocated, the frame fence has to be waited on
+	void FrustumCuller::setBuffers(uint32_t frame, const Buffer& objectBuffer, const Buffer& instanceBuffer, const Buffer& drawCommandBuffer)
+	{
+		std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+		bufferInfos[0].buffer = objectBuffer.getBuffer();
+		bufferInfos[1].buffer = instanceBuffer.getBuffer();
+		bufferInfos[2].buffer = drawCommandBuffer.getBuffer();
+
+		std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+		for (uint32_t i = 0; i < descriptorWrites.size(); ++i)
+		{
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+
+			descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[i].dstSet = descriptorSets[frame];
+			descriptorWrites[i].dstBinding = i;
+			descriptorWrites[i].dstArrayElement = 0;
+			descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[i].descriptorCount = 1;
+			descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(device.getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	}
+
+	//called whenever the pyramid was recreated, the device has to be idle
+	void FrustumCuller::setDepthPyramid(const DepthPyramid& depthPyramid)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = depthPyramid.getSampler();
+		imageInfo.imageView = depthPyramid.getView();
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		for (auto descriptorSet : descriptorSets)
+		{
+			VkWriteDescriptorSet descriptorWrite{};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = descriptorSet;
+			descriptorWrite.dstBinding = 4;
+			descriptorWrite.dstArrayElement = 0;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pImageInfo = &imageInfo;
+
+			vkUpdateDescriptorSets(device.getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+		}
+	}
+
+	//called every frame even when the recorded commands are reused, nothing camera dependent is baked into them
+	//the frame fence was waited on, so the counters of this frame's last use can be read and reset
+	//objects are projected with the previous view projection, the one the pyramid was rendered with
+	void FrustumCuller::update(uint32_t frame, const Camera& camera, uint32_t objectCount, const DepthPyramid& depthPyramid, bool occlusionCulling)
+	{
+		auto* frameStats = static_cast<CullStats*>(statsBuffers[frame]->getMappedData());
+		stats = *frameStats;
+		*frameStats = CullStats{};
+
+		CullData cullData{};
+		const auto& planes = camera.getFrustumPlanes();
+		std::copy(planes.begin(), planes.end(), cullData.frustumPlanes);
+		cullData.previousViewProjection = previousViewProjection;
+		cullData.pyramidSize = glm::vec2(depthPyramid.getExtent().width, depthPyramid.getExtent().height);
+		cullData.objectCount = objectCount;
+		cullData.occlusionCulling = occlusionCulling && depthPyramid.isValid();
+		uniformBuffers[frame]->setData(&cullData, sizeof(CullData));
+
+		previousViewProjection = camera.getViewProjection();
+	}
+
+	//recorded outside of the render pass, the barrier makes the results visible to the indirect draw and the vertex shader
+	//and the stats to the host, which reads them in update once the frame fence signaled
+	void FrustumCuller::record(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t objectCount) const
+	{
+		if (objectCount == 0)
+			return;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[frame], 0, nullptr);
+		vkCmdDispatch(commandBuffer, (objectCount + groupSize - 1) / groupSize, 1, 1);
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	//of the previous time this frame was drawn
+	const CullStats& FrustumCuller::getStats() const noexcept
+	{
+		return stats;
+	}
+
+	void FrustumCuller::createDescriptorSets()
+	{
+		std::array<VkDescriptorPoolSize, 3> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[0].descriptorCount = 4 * maxFramesInFlight;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		poolSizes[1].descriptorCount = maxFramesInFlight;
+		poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[2].descriptorCount = maxFramesInFlight;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = maxFramesInFlight;
+
+		assert(vkCreateDescriptorPool(device.getLogicalDevice(), &poolInfo, nullptr, &descriptorPool) == VK_SUCCESS, "cant create culling descriptor pool");
+
+		std::vector<VkDescriptorSetLayout> layouts(maxFramesInFlight, descriptorLayout);
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = maxFramesInFlight;
+		allocInfo.pSetLayouts = layouts.data();
+
+		descriptorSets.resize(maxFramesInFlight);
+		assert(vkAllocateDescriptorSets(device.getLogicalDevice(), &allocInfo, descriptorSets.data()) == VK_SUCCESS, "cant allocate culling descriptor sets");
+	}
+
+	//cull data and stats never change size, they are written into the sets once
+	void FrustumCuller::createFrameBuffers()
+	{
+		const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		for (uint32_t i = 0; i < maxFramesInFlight; ++i)
+		{
+			uniformBuffers.push_back(std::make_unique<Buffer>(device, sizeof(CullData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostVisible));
+			statsBuffers.push_back(std::make_unique<Buffer>(device, sizeof(CullStats), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible));
+
+			CullStats emptyStats{};
+			statsBuffers[i]->setData(&emptyStats, sizeof(CullStats));
+
+			std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+			bufferInfos[0].buffer = uniformBuffers[i]->getBuffer();
+			bufferInfos[0].range = sizeof(CullData);
+			bufferInfos[1].buffer = statsBuffers[i]->getBuffer();
+			bufferInfos[1].range = sizeof(CullStats);
+
+			std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[0].dstSet = descriptorSets[i];
+			descriptorWrites[0].dstBinding = 3;
+			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrites[0].descriptorCount = 1;
+			descriptorWrites[0].pBufferInfo = &bufferInfos[0];
+
+			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[1].dstSet = descriptorSets[i];
+			descriptorWrites[1].dstBinding = 5;
+			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[1].descriptorCount = 1;
+			descriptorWrites[1].pBufferInfo = &bufferInfos[1];
+
+			vkUpdateDescriptorSets(device.getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+		}
+	}
+
+	//cull.spv was hot reloaded, returns the replaced pipeline which frames in flight may still run
+	//the layouts stay since a reload cant change the shader interface
+	VkPipeline FrustumCuller::reloadPipeline()
+	{
+		VkPipeline replaced = pipeline;
+		createPipeline();
+		return replaced;
+	}
+
+	//objects, instances, draw commands, cull data, depth pyramid and stats, the layouts come from the shader and the layout cache owns them
+	void FrustumCuller::createPipeline()
+	{
+		Vk::Shader cullShader(device.getLogicalDevice(), "cull.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		const ShaderReflection& reflection = cullShader.getReflection();
+
+		LayoutCache& layoutCache = device.getLayoutCache();
+		descriptorLayout = layoutCache.getSetLayout(reflection, 0);
+		pipelineLayout = layoutCache.getPipelineLayout(reflection);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = cullShader.getCreateInfo();
+		pipelineInfo.layout = pipelineLayout;
+
+		assert(vkCreateComputePipelines(device.getLogicalDevice(), device.getPipelineCache().getCache(), 1, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS, "cant create culling pipeline");
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Camera.hpp"
+#include "DepthPyramid.hpp"
+
+namespace Vk
+{
+	//std140 layout, one uniform buffer per frame in flight
+	struct CullData
+	{
+		glm::vec4 frustumPlanes[6];
+		glm::mat4 previousViewProjection{ 1.0f };
+		glm::vec2 pyramidSize{ 0.0f };
+		uint32_t objectCount = 0;
+		uint32_t occlusionCulling = 0;
+	};
+
+	//counted by the culling pass, read back once the frame's fence has signaled
+	struct CullStats
+	{
+		uint32_t frustumCulled = 0;
+		uint32_t occlusionCulled = 0;
+		uint32_t visible = 0;
+	};
+
+	//compute pass run before the render pass, every object whose bounding sphere is inside the camera frustum
+	//and not behind the depth pyramid of the previous frame is copied to the instance buffer and counted into its draw command,
+	//the rest never reach the rasterizer
+	//draw commands come in with instanceCount zero and firstInstance reserving room for all of their objects
+	class FrustumCuller
+	{
+	public:
+		static constexpr uint32_t groupSize = 64;
+
+		explicit FrustumCuller(const Device& device, uint32_t maxFramesInFlight);
+		~FrustumCuller();
+
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+		void setBuffers(uint32_t frame, const Buffer& objectBuffer, const Buffer& instanceBuffer, const Buffer& drawCommandBuffer);
+		void setDepthPyramid(const DepthPyramid& depthPyramid);
+		void update(uint32_t frame, const Camera& camera, uint32_t objectCount, const DepthPyramid& depthPyramid, bool occlusionCulling);
+		void record(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t objectCount) const;
+		VkPipeline reloadPipeline();
+		const CullStats& getStats() const noexcept;
+
+	private:
+		void createDescriptorSets();
+		void createFrameBuffers();
+		void createPipeline();
+
+	private:
+		const Device& device;
+		const uint32_t maxFramesInFlight;
+		VkDescriptorSetLayout descriptorLayout;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> descriptorSets;
+		VkPipelineLayout pipelineLayout;
+		VkPipeline pipeline;
+		std::vector<std::unique_ptr<Buffer>> uniformBuffers;
+		std::vector<std::unique_ptr<Buffer>> statsBuffers;
+		glm::mat4 previousViewProjection;
+		CullStats stats;
+	};
+}
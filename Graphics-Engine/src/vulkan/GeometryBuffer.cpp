@@ -0,0 +1,109 @@
+#include "GeometryBuffer.hpp"
+#include "../utils/assert.hpp"
+#include "../utils/Logger.hpp"
+
+namespace Vk
+{
+	GeometryBuffer::GeometryBuffer(const Device& device, uint32_t maxVertices, uint32_t maxIndices)
+		:device(device), maxVertices(maxVertices), maxIndices(maxIndices), vertexCount(0), indexCount(0), meshCount(0)
+	{
+		vertexBuffer = std::make_unique<Buffer>(device, sizeof(Vertex) * static_cast<VkDeviceSize>(maxVertices),
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		indexBuffer = std::make_unique<Buffer>(device, sizeof(uint32_t) * static_cast<VkDeviceSize>(maxIndices),
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		LOG_INFO("geometry buffer holds up to " + STR(maxVertices) + " vertices and " + STR(maxIndices) + " indices");
+	}
+
+	GeometryBuffer::~GeometryBuffer()
+	{
+
+	}
+
+	//indices stay relative to the mesh, vertexOffset moves them to its vertices in the shared buffer
+	Mesh GeometryBuffer::add(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		assert(vertexCount + vertices.size() <= maxVertices && indexCount + indices.size() <= maxIndices, "geometry buffer is full");
+
+		Mesh mesh{};
+		mesh.id = meshCount++;
+		mesh.firstIndex = indexCount;
+		mesh.indexCount = static_cast<uint32_t>(indices.size());
+		mesh.vertexOffset = static_cast<int32_t>(vertexCount);
+
+		//sphere around the bounding box center, loose but cheap to build and to test
+		if (!vertices.empty())
+		{
+			glm::vec3 minimum = vertices[0].position, maximum = vertices[0].position;
+			for (const auto& vertex : vertices)
+			{
+				minimum = glm::min(minimum, vertex.position);
+				maximum = glm::max(maximum, vertex.position);
+			}
+
+			glm::vec3 center = (minimum + maximum) * 0.5f;
+			float radius = 0.0f;
+			for (const auto& vertex : vertices)
+				radius = glm::max(radius, glm::length(vertex.position - center));
+
+			mesh.boundingSphere = glm::vec4(center, radius);
+		}
+
+		auto& uploadContext = device.getUploadContext();
+		uploadContext.copyBuffer(vertices.data(), sizeof(Vertex) * vertices.size(), vertexBuffer->getBuffer(), sizeof(Vertex) * static_cast<VkDeviceSize>(vertexCount));
+		mesh.uploadToken = uploadContext.copyBuffer(indices.data(), sizeof(uint32_t) * indices.size(), indexBuffer->getBuffer(), sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount));
+
+		vertexCount += static_cast<uint32_t>(vertices.size());
+		indexCount += static_cast<uint32_t>(indices.size());
+
+		return mesh;
+	}
+
+	//unit square in the xy plane added the first time it is asked for, every image draws it scaled to its size
+	//so loading images never grows the buffer and all of them end up in one instanced draw
+	const Mesh& GeometryBuffer::getQuad()
+	{
+		if (quad)
+			return *quad;
+
+		std::vector<Vertex> vertices(4, { glm::vec3{0.0f}, glm::vec3{0.0f} });
+		vertices[0].position = glm::vec3{ -0.5f, -0.5f, 0.0f };
+		vertices[0].texCord = glm::vec2{ 1.0f, 0.0f };
+		vertices[1].position = glm::vec3{ 0.5f, -0.5f, 0.0f };
+		vertices[1].texCord = glm::vec2{ 0.0f };
+		vertices[2].position = glm::vec3{ 0.5f, 0.5f, 0.0f };
+		vertices[2].texCord = glm::vec2{ 0.0f, 1.0f };
+		vertices[3].position = glm::vec3{ -0.5f, 0.5f, 0.0f };
+		vertices[3].texCord = glm::vec2{ 1.0f };
+
+		std::vector<uint32_t> indices = {
+			0, 1, 2, 2, 3, 0
+		};
+
+		quad = add(vertices, indices);
+		return *quad;
+	}
+
+	void GeometryBuffer::bind(VkCommandBuffer commandBuffer) const
+	{
+		VkBuffer rawVertexBuffer = vertexBuffer->getBuffer();
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &rawVertexBuffer, &offset);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	uint32_t GeometryBuffer::getMeshCount() const noexcept
+	{
+		return meshCount;
+	}
+
+	uint32_t GeometryBuffer::getVertexCount() const noexcept
+	{
+		return vertexCount;
+	}
+
+	uint32_t GeometryBuffer::getIndexCount() const noexcept
+	{
+		return indexCount;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include <optional>
+#include "Buffer.hpp"
+
+namespace Vk
+{
+	//range of the shared geometry buffers one mesh occupies, copied freely between objects drawing the same mesh
+	struct Mesh
+	{
+		uint32_t id = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		int32_t vertexOffset = 0;
+		UploadToken uploadToken = 0;
+		glm::vec4 boundingSphere{ 0.0f }; //center in mesh space and radius
+	};
+
+	//one vertex and one index buffer every mesh is suballocated from, so the whole scene draws
+	//after binding them once and each mesh is just an indexed range in VkDrawIndexedIndirectCommand
+	//space is handed out linearly and only given back when the device is destroyed
+	class GeometryBuffer
+	{
+	public:
+		explicit GeometryBuffer(const Device& device, uint32_t maxVertices = 1 << 20, uint32_t maxIndices = 1 << 22);
+		~GeometryBuffer();
+
+		GeometryBuffer(const GeometryBuffer&) = delete;
+		GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+		Mesh add(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		const Mesh& getQuad();
+		void bind(VkCommandBuffer commandBuffer) const;
+		uint32_t getMeshCount() const noexcept;
+		uint32_t getVertexCount() const noexcept;
+		uint32_t getIndexCount() const noexcept;
+
+	private:
+		const Device& device;
+		const uint32_t maxVertices, maxIndices;
+		std::unique_ptr<Buffer> vertexBuffer, indexBuffer;
+		uint32_t vertexCount, indexCount, meshCount;
+		std::optional<Mesh> quad;
+	};
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cmath>
+#include "GpuProfiler.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	constexpr uint32_t noQuery = UINT32_MAX;
+
+	GpuProfiler::Scope::Scope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name)
+		:profiler(profiler), commandBuffer(commandBuffer), query(profiler.beginScope(commandBuffer, name))
+	{
+	}
+
+	GpuProfiler::Scope::~Scope()
+	{
+		profiler.endScope(commandBuffer, query);
+	}
+
+	GpuProfiler::GpuProfiler(const Device& device, uint32_t maxFramesInFlight, uint32_t maxScopes, uint32_t historySize)
+		:device(device), maxFramesInFlight(maxFramesInFlight), maxScopes(maxScopes), historySize(historySize), supported(false),
+		timestampPeriod(1.0), timestampMask(0), frameScopes(maxFramesInFlight), frameSubmitted(maxFramesInFlight, false),
+		results(maxScopes * 2), recordingFrame(0)
+	{
+		createQueryPools();
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for (VkQueryPool queryPool : queryPools)
+			vkDestroyQueryPool(device.getLogicalDevice(), queryPool, nullptr);
+	}
+
+	//has to come first in the primary command buffer, before any scope and outside of a render pass
+	void GpuProfiler::begin(VkCommandBuffer commandBuffer, uint32_t frame)
+	{
+		recordingFrame = frame;
+		frameScopes[frame].clear();
+		if (!supported)
+			return;
+
+		vkCmdResetQueryPool(commandBuffer, queryPools[frame], 0, maxScopes * 2);
+	}
+
+	//a recorded or reused command buffer of the frame was submitted, its timestamps are read by the next collect
+	void GpuProfiler::submitted(uint32_t frame)
+	{
+		frameSubmitted[frame] = true;
+	}
+
+	//called once the frame's fence has signaled and before it is submitted again, every submission is read exactly once
+	//frames skipped by a swap chain recreation call it again without a new submission and read nothing
+	void GpuProfiler::collect(uint32_t frame)
+	{
+		const auto& scopes = frameScopes[frame];
+		if (!supported || !frameSubmitted[frame] || scopes.empty())
+			return;
+		frameSubmitted[frame] = false;
+
+		const uint32_t queryCount = static_cast<uint32_t>(scopes.size() * 2);
+		VkResult result = vkGetQueryPoolResults(device.getLogicalDevice(), queryPools[frame], 0, queryCount,
+			sizeof(uint64_t) * queryCount, results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+			return;
+
+		for (size_t i = 0; i < scopes.size(); ++i)
+		{
+			const uint64_t ticks = (results[i * 2 + 1] - results[i * 2]) & timestampMask;
+			addSample(scopes[i], static_cast<double>(ticks) * timestampPeriod / 1e6);
+		}
+	}
+
+	//scopes in the order they were first written
+	std::vector<GpuScopeStats> GpuProfiler::getStats() const
+	{
+		std::vector<GpuScopeStats> stats;
+		std::vector<double> sorted;
+		for (const History& history : histories)
+		{
+			GpuScopeStats scopeStats;
+			scopeStats.name = history.name;
+			scopeStats.sampleCount = static_cast<uint32_t>(history.samples.size());
+			if (history.samples.empty())
+			{
+				stats.push_back(scopeStats);
+				continue;
+			}
+
+			sorted = history.samples;
+			std::sort(sorted.begin(), sorted.end());
+			auto percentile = [&sorted](double fraction) {
+				return sorted[static_cast<size_t>(std::ceil(fraction * sorted.size())) - 1];
+			};
+
+			double sum = 0.0;
+			for (double sample : sorted)
+				sum += sample;
+
+			scopeStats.average = sum / sorted.size();
+			scopeStats.median = percentile(0.5);
+			scopeStats.percentile95 = percentile(0.95);
+			scopeStats.percentile99 = percentile(0.99);
+			scopeStats.last = history.samples[(history.next + history.samples.size() - 1) % history.samples.size()];
+			stats.push_back(scopeStats);
+		}
+
+		return stats;
+	}
+
+	//queues without timestamp bits leave every scope empty
+	bool GpuProfiler::isSupported() const noexcept
+	{
+		return supported;
+	}
+
+	//a scope over the query budget of the frame is left out
+	uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name)
+	{
+		auto& scopes = frameScopes[recordingFrame];
+		if (!supported || scopes.size() >= maxScopes)
+			return noQuery;
+
+		auto [found, inserted] = historyIndices.try_emplace(name, static_cast<uint32_t>(histories.size()));
+		if (inserted)
+			histories.push_back({ name, {}, 0 });
+
+		const uint32_t query = static_cast<uint32_t>(scopes.size() * 2);
+		scopes.push_back(found->second);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[recordingFrame], query);
+		return query;
+	}
+
+	//bottom of pipe waits for everything recorded in the scope to finish
+	void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t query)
+	{
+		if (query != noQuery)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[recordingFrame], query + 1);
+	}
+
+	void GpuProfiler::createQueryPools()
+	{
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, families.data());
+
+		const uint32_t graphicsFamily = device.getQueueFamilies(device.getPhysicalDevice()).graphicsFamily.value();
+		const uint32_t validBits = families[graphicsFamily].timestampValidBits;
+		if (validBits == 0)
+		{
+			LOG_WARNING("graphics queue has no timestamps, gpu profiling is off");
+			return;
+		}
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+		timestampPeriod = properties.limits.timestampPeriod;
+		timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = maxScopes * 2;
+
+		queryPools.resize(maxFramesInFlight);
+		for (VkQueryPool& queryPool : queryPools)
+			assert(vkCreateQueryPool(device.getLogicalDevice(), &queryPoolInfo, nullptr, &queryPool) == VK_SUCCESS, "cant create timestamp query pool");
+
+		supported = true;
+	}
+
+	void GpuProfiler::addSample(uint32_t history, double milliseconds)
+	{
+		History& scopeHistory = histories[history];
+		if (scopeHistory.samples.size() < historySize)
+			scopeHistory.samples.push_back(milliseconds);
+		else
+			scopeHistory.samples[scopeHistory.next] = milliseconds;
+		scopeHistory.next = (scopeHistory.next + 1) % historySize;
+	}
+}
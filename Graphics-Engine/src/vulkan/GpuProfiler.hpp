@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Device.hpp"
+
+namespace Vk
+{
+	//gpu time of one scope over the last samples, milliseconds
+	struct GpuScopeStats
+	{
+		std::string name;
+		double average = 0.0;
+		double median = 0.0;
+		double percentile95 = 0.0;
+		double percentile99 = 0.0;
+		double last = 0.0;
+		uint32_t sampleCount = 0;
+	};
+
+	//timestamp queries around passes of the frame, one query pool per frame in flight
+	//results are read when the frame comes around again and its fence has signaled, so nothing waits for them
+	//scopes are written into the primary command buffer on the render thread, a reused buffer writes the same scopes again
+	class GpuProfiler
+	{
+	public:
+		//timestamps written before and after the commands recorded while it lives
+		class Scope
+		{
+		public:
+			explicit Scope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name);
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			GpuProfiler& profiler;
+			VkCommandBuffer commandBuffer;
+			uint32_t query;
+		};
+
+		explicit GpuProfiler(const Device& device, uint32_t maxFramesInFlight, uint32_t maxScopes = 32, uint32_t historySize = 240);
+		~GpuProfiler();
+
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+		void begin(VkCommandBuffer commandBuffer, uint32_t frame);
+		void submitted(uint32_t frame);
+		void collect(uint32_t frame);
+		std::vector<GpuScopeStats> getStats() const;
+		bool isSupported() const noexcept;
+
+	private:
+		struct History
+		{
+			std::string name;
+			std::vector<double> samples; //ring of the last historySize times
+			size_t next = 0;
+		};
+
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+		void endScope(VkCommandBuffer commandBuffer, uint32_t query);
+		void createQueryPools();
+		void addSample(uint32_t history, double milliseconds);
+
+	private:
+		const Device& device;
+		const uint32_t maxFramesInFlight;
+		const uint32_t maxScopes;
+		const uint32_t historySize;
+		bool supported;
+		double timestampPeriod; //nanoseconds per tick
+		uint64_t timestampMask;
+		std::vector<VkQueryPool> queryPools;
+		std::vector<std::vector<uint32_t>> frameScopes; //history index of every scope written into the frame's pool
+		std::vector<bool> frameSubmitted; //the frame's pool was written since it was last read
+		std::vector<uint64_t> results;
+		std::vector<History> histories;
+		std::unordered_map<std::string, uint32_t> historyIndices;
+		uint32_t recordingFrame;
+	};
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include "LayoutCache.hpp"
+#include "Device.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	LayoutCache::LayoutCache(const Device& device)
+		:device(device)
+	{
+	}
+
+	LayoutCache::~LayoutCache()
+	{
+		for (auto& [key, layout] : pipelineLayouts)
+			vkDestroyPipelineLayout(device.getLogicalDevice(), layout, nullptr);
+		for (auto& [key, layout] : setLayouts)
+			vkDestroyDescriptorSetLayout(device.getLogicalDevice(), layout, nullptr);
+	}
+
+	//bindings are compared by value, their order does not matter
+	VkDescriptorSetLayout LayoutCache::getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		std::vector<VkDescriptorSetLayoutBinding> sorted = bindings;
+		std::sort(sorted.begin(), sorted.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+			return a.binding < b.binding;
+		});
+
+		std::vector<uint64_t> key;
+		key.reserve(sorted.size() * 4);
+		for (const auto& binding : sorted)
+		{
+			assert(binding.pImmutableSamplers == nullptr, "cant cache descriptor set layout with immutable samplers");
+			key.insert(key.end(), { binding.binding, static_cast<uint64_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags });
+		}
+
+		auto found = setLayouts.find(key);
+		if (found != setLayouts.end())
+			return found->second;
+
+		VkDescriptorSetLayoutCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		createInfo.bindingCount = static_cast<uint32_t>(sorted.size());
+		createInfo.pBindings = sorted.data();
+
+		VkDescriptorSetLayout layout;
+		assert(vkCreateDescriptorSetLayout(device.getLogicalDevice(), &createInfo, nullptr, &layout) == VK_SUCCESS, "cant create descriptor layout");
+
+		setLayouts.emplace(std::move(key), layout);
+		return layout;
+	}
+
+	//one set of the reflected bindings, runtime arrays need flags reflection cant know and have to come as external sets
+	VkDescriptorSetLayout LayoutCache::getSetLayout(const ShaderReflection& reflection, uint32_t set)
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		for (const ShaderBinding& shaderBinding : reflection.bindings)
+		{
+			if (shaderBinding.set != set)
+				continue;
+
+			assert(shaderBinding.count != 0, "cant create descriptor layout of runtime array from reflection");
+
+			VkDescriptorSetLayoutBinding binding{};
+			binding.binding = shaderBinding.binding;
+			binding.descriptorType = shaderBinding.type;
+			binding.descriptorCount = shaderBinding.count;
+			binding.stageFlags = shaderBinding.stages;
+			binding.pImmutableSamplers = nullptr;
+			bindings.push_back(binding);
+		}
+
+		return getSetLayout(bindings);
+	}
+
+	VkPipelineLayout LayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& layouts, const std::vector<VkPushConstantRange>& pushConstants)
+	{
+		std::vector<uint64_t> key;
+		key.reserve(1 + layouts.size() + pushConstants.size() * 3);
+		key.push_back(layouts.size());
+		for (VkDescriptorSetLayout setLayout : layouts)
+			key.push_back(reinterpret_cast<uint64_t>(setLayout));
+		for (const auto& range : pushConstants)
+			key.insert(key.end(), { range.stageFlags, range.offset, range.size });
+
+		auto found = pipelineLayouts.find(key);
+		if (found != pipelineLayouts.end())
+			return found->second;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
+		pipelineLayoutInfo.pSetLayouts = layouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstants.empty() ? nullptr : pushConstants.data();
+
+		VkPipelineLayout layout;
+		assert(vkCreatePipelineLayout(device.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &layout) == VK_SUCCESS, "cant create pipeline layout");
+
+		pipelineLayouts.emplace(std::move(key), layout);
+		LOG_INFO("pipeline layout created, " + STR(pipelineLayouts.size()) + " pipeline and " + STR(setLayouts.size()) + " set layouts in cache");
+		return layout;
+	}
+
+	//sets up to the highest one the shaders use, external sets replace reflected ones and gaps get an empty layout
+	VkPipelineLayout LayoutCache::getPipelineLayout(const ShaderReflection& reflection, const ExternalSets& externalSets)
+	{
+		uint32_t setCount = externalSets.empty() ? 0 : externalSets.rbegin()->first + 1;
+		if (!reflection.bindings.empty())
+			setCount = std::max(setCount, reflection.bindings.back().set + 1);
+
+		std::vector<VkDescriptorSetLayout> layouts(setCount);
+		for (uint32_t set = 0; set < setCount; ++set)
+		{
+			auto external = externalSets.find(set);
+			layouts[set] = external != externalSets.end() ? external->second : getSetLayout(reflection, set);
+		}
+
+		return getPipelineLayout(layouts, reflection.pushConstants);
+	}
+
+	size_t LayoutCache::getSetLayoutCount() const noexcept
+	{
+		return setLayouts.size();
+	}
+
+	size_t LayoutCache::getPipelineLayoutCount() const noexcept
+	{
+		return pipelineLayouts.size();
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <map>
+#include "ShaderReflection.hpp"
+
+namespace Vk
+{
+	class Device;
+
+	//descriptor set and pipeline layouts built from shader reflection, equal ones are created only once
+	//layouts live as long as the device, users never destroy what they get from here
+	//used from the render thread only
+	class LayoutCache
+	{
+	public:
+		using ExternalSets = std::map<uint32_t, VkDescriptorSetLayout>;
+
+		explicit LayoutCache(const Device& device);
+		~LayoutCache();
+
+		LayoutCache(const LayoutCache&) = delete;
+		LayoutCache& operator=(const LayoutCache&) = delete;
+
+		VkDescriptorSetLayout getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+		VkDescriptorSetLayout getSetLayout(const ShaderReflection& reflection, uint32_t set);
+		VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& layouts, const std::vector<VkPushConstantRange>& pushConstants);
+		VkPipelineLayout getPipelineLayout(const ShaderReflection& reflection, const ExternalSets& externalSets = {});
+		size_t getSetLayoutCount() const noexcept;
+		size_t getPipelineLayoutCount() const noexcept;
+
+	private:
+		const Device& device;
+		std::map<std::vector<uint64_t>, VkDescriptorSetLayout> setLayouts;
+		std::map<std::vector<uint64_t>, VkPipelineLayout> pipelineLayouts;
+	};
+}
@@ -1,25 +1,24 @@
 #include <array>
 #include "Pipeline.hpp"
-#include "Shader.hpp"
 #include "../utils/assert.hpp"
 #include "Buffer.hpp"
+#include "TextureTable.hpp"
+#include "LayoutCache.hpp"
+#include "Shader.hpp"
 
 namespace Vk 
 {
 
 	Pipeline::Pipeline(const Device& device, SwapChain& swapChain)
-		: device(device), swapChain(swapChain), descriptorLayout(VK_NULL_HANDLE),
-		pipelineLayout(VK_NULL_HANDLE), pipeline(VK_NULL_HANDLE), renderPass(VK_NULL_HANDLE)
+		: device(device), swapChain(swapChain), descriptorLayout(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE), renderPass(VK_NULL_HANDLE)
 	{
 		init();
 	}
 
 	Pipeline::~Pipeline()
 	{
-		vkDestroyDescriptorSetLayout(device.getLogicalDevice(), descriptorLayout, nullptr);
-		vkDestroyPipelineLayout(device.getLogicalDevice(), pipelineLayout, nullptr);
+		manager.reset();
 		vkDestroyRenderPass(device.getLogicalDevice(), renderPass, nullptr);
-		vkDestroyPipeline(device.getLogicalDevice(), pipeline, nullptr);
 	}
 
 	VkRenderPass Pipeline::getRenderPass() const
@@ -27,9 +26,23 @@ namespace Vk
 		return renderPass;
 	}
 
+	//pipeline of the default state, asked for every time since a shader reload replaces it
 	VkPipeline Pipeline::getPipeline() const
 	{
-		return pipeline;
+		return manager->getPipeline(getDefaultState());
+	}
+
+	//every variant is created for this render pass and layout
+	PipelineManager& Pipeline::getManager() const noexcept
+	{
+		return *manager;
+	}
+
+	PipelineState Pipeline::getDefaultState() const noexcept
+	{
+		PipelineState state{};
+		state.renderPass = renderPass;
+		return state;
 	}
 
 	VkPipelineLayout Pipeline::getLayout() const noexcept
@@ -44,147 +57,38 @@ namespace Vk
 
 	void Pipeline::init()
 	{
-		createDescriptorLayout();
-		createPipelineLayout();
+		createLayouts();
 		createRenderPass();
 		swapChain.createFrameBuffers(renderPass);
 		createPipeline();	
 	}
 
-	void Pipeline::createDescriptorLayout()
+	//layouts come from what the default shaders declare, the layout cache owns them
+	//set 0 is the bindless texture table, its flags cant be reflected so its own layout is used
+	//set 1 is data that changes every frame
+	void Pipeline::createLayouts()
 	{
-		//VkDescriptorSetLayoutBinding descriptorBinding{};
-		//descriptorBinding.binding = 0;
-		//descriptorBinding.descriptorCount = 1;
-		//descriptorBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		//descriptorBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		//descriptorBinding.pImmutableSamplers = nullptr;
+		Shader vertShader(device.getLogicalDevice(), "vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+		Shader fragShader(device.getLogicalDevice(), "frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
 
-		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-		samplerLayoutBinding.binding = 1;
-		samplerLayoutBinding.descriptorCount = 1;
-		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		samplerLayoutBinding.pImmutableSamplers = nullptr;
-		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		ShaderReflection reflection = vertShader.getReflection();
+		reflection.merge(fragShader.getReflection());
 
-		VkDescriptorSetLayoutCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		createInfo.bindingCount = 1;
-		createInfo.pBindings = &samplerLayoutBinding;
+		const ShaderBinding* textures = reflection.findBinding(0, TextureTable::binding);
+		assert(textures != nullptr && textures->type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, "default shaders dont sample the texture table");
 
-		assert(vkCreateDescriptorSetLayout(device.getLogicalDevice(), &createInfo, nullptr, &descriptorLayout) == VK_SUCCESS, "cant create descriptor layout");
+		LayoutCache& layoutCache = device.getLayoutCache();
+		descriptorLayout = layoutCache.getSetLayout(reflection, 1);
+		pipelineLayout = layoutCache.getPipelineLayout(reflection, { { 0, device.getTextureTable().getLayout() } });
 	}
 
+	//the default state is created up front, it is what objects fall back to while their own pipeline compiles
+	//states from the last run start compiling in the background right away
 	void Pipeline::createPipeline()
 	{
-
-		Vk::Shader vertShader(device.getLogicalDevice(), "vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
-		Vk::Shader fragShader(device.getLogicalDevice(), "frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
-		std::array shaderStages { vertShader.getCreateInfo(), fragShader.getCreateInfo() };
-
-		auto bindingDescriptions = Vertex::getBindingDescriptions();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		VkDynamicState dynamicStateEnables[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-		VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
-		dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicStateInfo.pDynamicStates = dynamicStateEnables;
-		dynamicStateInfo.dynamicStateCount = 2;
-		dynamicStateInfo.flags = 0;
-
-		VkPipelineViewportStateCreateInfo viewportState{};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = nullptr;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = nullptr;
-
-		VkPipelineRasterizationStateCreateInfo rasterizer{};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_NONE;
-		rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;
-		rasterizer.depthBiasConstantFactor = 0.0f; 
-		rasterizer.depthBiasClamp = 0.0f; 
-		rasterizer.depthBiasSlopeFactor = 0.0f; 
-
-		VkPipelineMultisampleStateCreateInfo multisampling{};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		multisampling.minSampleShading = 1.0f; 
-		multisampling.pSampleMask = nullptr; 
-		multisampling.alphaToCoverageEnable = VK_FALSE; 
-		multisampling.alphaToOneEnable = VK_FALSE; 
-
-		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; 
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; 
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; 
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-		VkPipelineColorBlendStateCreateInfo colorBlending{};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY; 
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f; 
-		colorBlending.blendConstants[1] = 0.0f;
-		colorBlending.blendConstants[2] = 0.0f;
-		colorBlending.blendConstants[3] = 0.0f; 
-
-		VkPipelineDepthStencilStateCreateInfo depthStencilInfo{};
-		depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencilInfo.depthTestEnable = VK_TRUE;
-		depthStencilInfo.depthWriteEnable = VK_TRUE;
-		depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
-		depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
-		depthStencilInfo.minDepthBounds = 0.0f;  
-		depthStencilInfo.maxDepthBounds = 1.0f; 
-		depthStencilInfo.stencilTestEnable = VK_FALSE;
-		depthStencilInfo.front = {};  
-		depthStencilInfo.back = {};  
-
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineInfo.pStages = shaderStages.data();
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = &depthStencilInfo;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = &dynamicStateInfo;
-		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.renderPass = renderPass;
-		pipelineInfo.subpass = 0;
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; 
-		pipelineInfo.basePipelineIndex = -1; 
-
-		assert(vkCreateGraphicsPipelines(device.getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS, "cant create pipeline");
+		manager = std::make_unique<PipelineManager>(device, pipelineLayout);
+		manager->prewarm(renderPass);
+		manager->getPipeline(getDefaultState());
 	}
 
 	void Pipeline::createRenderPass()
@@ -207,11 +111,12 @@ namespace Vk
 			depthAttachment.format = findDepthFormat();
 			depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 			depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 			depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 			depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 			depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			//kept and left readable for the depth pyramid build after the pass
+			depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
 			VkAttachmentReference depthAttachmentRef{};
 			depthAttachmentRef.attachment = 1;
@@ -223,13 +128,21 @@ namespace Vk
 			subpass.pColorAttachments = &colorAttachmentRef;
 			subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-			VkSubpassDependency dependency = {};
-			dependency.dstSubpass = 0;
-			dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependency.srcAccessMask = 0;
-			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+			//the depth image may still be read by the previous pyramid build
+			std::array<VkSubpassDependency, 2> dependencies{};
+			dependencies[0].dstSubpass = 0;
+			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependencies[0].srcAccessMask = 0;
+			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+			dependencies[1].srcSubpass = 0;
+			dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+			dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
 			std::array attachments = { colorAttachment, depthAttachment };
 
@@ -239,8 +152,8 @@ namespace Vk
 			renderPassInfo.pAttachments = attachments.data();
 			renderPassInfo.subpassCount = 1;
 			renderPassInfo.pSubpasses = &subpass;
-			renderPassInfo.dependencyCount = 1;
-			renderPassInfo.pDependencies = &dependency;
+			renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+			renderPassInfo.pDependencies = dependencies.data();
 
 			assert(vkCreateRenderPass(device.getLogicalDevice(), &renderPassInfo, nullptr, &renderPass) == VK_SUCCESS, "cant create render pass");
 	}
@@ -250,25 +163,7 @@ namespace Vk
 		return device.getSupportedFormat(
 		  {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
 		  VK_IMAGE_TILING_OPTIMAL,
-		  VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		  VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT //the depth pyramid samples it
 		);
 	}
-
-	void Pipeline::createPipelineLayout()
-	{
-
-		VkPushConstantRange pushConstant{};
-		pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		pushConstant.offset = 0;
-		pushConstant.size = sizeof(PushConstant);
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1; 
-		pipelineLayoutInfo.pSetLayouts = &descriptorLayout;
-		pipelineLayoutInfo.pushConstantRangeCount = 1; 
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
-
-		assert(vkCreatePipelineLayout(device.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) == VK_SUCCESS, "cant create pipeline layout");
-	}
 }
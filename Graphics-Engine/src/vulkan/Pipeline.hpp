@@ -4,14 +4,43 @@
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <memory>
 #include "SwapChain.hpp"
+#include "PipelineManager.hpp"
 
 namespace Vk 
 {
-	struct PushConstant
+	//per object data the vertex shader reads at gl_InstanceIndex, std430 layout
+	//the model matrix is affine so only its three rows are stored
+	struct InstanceData
 	{
-		glm::mat4 model{ 1.0f };
+		glm::mat3x4 model{ 1.0f };
+		uint32_t textureIndex = 0;
+		uint32_t padding[3]{};
+
+		void setModel(const glm::mat4& matrix) noexcept
+		{
+			model = glm::transpose(glm::mat4x3(matrix));
+		}
+	};
+
+	//per object input of the culling pass, std430 layout
+	//instance is copied to the instance buffer when the bounding sphere is inside the frustum
+	struct ObjectData
+	{
+		InstanceData instance;
+		glm::vec4 boundingSphere{ 0.0f };
+		uint32_t drawCommand = 0;
+		uint32_t padding[3]{};
+	};
+
+	//camera and global data, one uniform buffer per frame in flight, std140 layout
+	struct FrameData
+	{
+		glm::mat4 view{ 1.0f };
+		glm::mat4 projection{ 1.0f };
 		glm::mat4 viewProjection{ 1.0f };
+		glm::vec4 cameraPosition{ 0.0f };
 	};
 
 	class Pipeline
@@ -25,13 +54,14 @@ namespace Vk
 
 		VkRenderPass getRenderPass() const;
 		VkPipeline getPipeline() const;
+		PipelineManager& getManager() const noexcept;
+		PipelineState getDefaultState() const noexcept;
 		VkPipelineLayout getLayout() const noexcept;
 		const VkDescriptorSetLayout getDescriptorSetLayout() const noexcept;
 
 	private:
 		void init();
-		void createDescriptorLayout();
-		void createPipelineLayout();
+		void createLayouts();
 		void createPipeline();
 		void createRenderPass();
 		VkFormat findDepthFormat() const;
@@ -41,7 +71,7 @@ namespace Vk
 		SwapChain& swapChain;
 		VkDescriptorSetLayout descriptorLayout;
 		VkPipelineLayout pipelineLayout;
-		VkPipeline pipeline;
 		VkRenderPass renderPass;
+		std::unique_ptr<PipelineManager> manager;
 	};
 }
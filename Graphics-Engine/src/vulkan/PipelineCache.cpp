@@ -0,0 +1,119 @@
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include "PipelineCache.hpp"
+#include "Device.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	PipelineCache::PipelineCache(const Device& device, const std::string& path)
+		:device(device), path(path), cache(VK_NULL_HANDLE), warm(false)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::vector<uint8_t> data = load();
+		warm = !data.empty();
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = data.size();
+		cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		assert(vkCreatePipelineCache(device.getLogicalDevice(), &cacheInfo, nullptr, &cache) == VK_SUCCESS, "cant create pipeline cache");
+
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (warm)
+			LOG_INFO("pipeline cache loaded " + STR(data.size()) + " bytes in " + STR(milliseconds) + " ms");
+		else
+			LOG_INFO("pipeline cache is cold");
+	}
+
+	PipelineCache::~PipelineCache()
+	{
+		//nothing may throw out of here, a cache that cant be written is only lost
+		try
+		{
+			save();
+		}
+		catch (const std::exception& error)
+		{
+			LOG_WARNING(std::string("cant save pipeline cache: ") + error.what());
+		}
+
+		vkDestroyPipelineCache(device.getLogicalDevice(), cache, nullptr);
+	}
+
+	VkPipelineCache PipelineCache::getCache() const noexcept
+	{
+		return cache;
+	}
+
+	//the file matched this device, pipelines created from it should mostly be hits
+	bool PipelineCache::isWarm() const noexcept
+	{
+		return warm;
+	}
+
+	void PipelineCache::save() const
+	{
+		size_t size = 0;
+		assert(vkGetPipelineCacheData(device.getLogicalDevice(), cache, &size, nullptr) == VK_SUCCESS, "cant get pipeline cache size");
+
+		std::vector<uint8_t> data(size);
+		assert(vkGetPipelineCacheData(device.getLogicalDevice(), cache, &size, data.data()) == VK_SUCCESS, "cant get pipeline cache data");
+		data.resize(size);
+
+		const std::string temporaryPath = path + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			assert(file.is_open(), "cant create pipeline cache file");
+
+			file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			file.flush();
+			assert(file.good(), "cant write pipeline cache file");
+		}
+
+		std::filesystem::rename(temporaryPath, path);
+		LOG_INFO("pipeline cache saved " + STR(data.size()) + " bytes");
+	}
+
+	//empty when there is no file or it was written by another driver or device
+	std::vector<uint8_t> PipelineCache::load() const
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return {};
+
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		if (!file.good() || !isCompatible(data))
+		{
+			LOG_WARNING("pipeline cache file is not usable on this device, starting empty");
+			return {};
+		}
+
+		return data;
+	}
+
+	//drivers are supposed to reject foreign data themselves, not all of them do it reliably
+	bool PipelineCache::isCompatible(const std::vector<uint8_t>& data) const
+	{
+		VkPipelineCacheHeaderVersionOne header{};
+		if (data.size() < sizeof(header))
+			return false;
+
+		memcpy(&header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+
+		return header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+			header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+			memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+
+namespace Vk
+{
+	class Device;
+
+	//driver pipeline cache kept on disk between runs, so warm starts skip most of the shader compilation
+	//the file is only used when it was written by the same driver and device, otherwise the cache starts empty
+	//it is written back on destruction into a temporary file that then replaces the old one, a crash never leaves half a cache
+	class PipelineCache
+	{
+	public:
+		explicit PipelineCache(const Device& device, const std::string& path = "pipeline.cache");
+		~PipelineCache();
+
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+
+		VkPipelineCache getCache() const noexcept;
+		bool isWarm() const noexcept;
+		void save() const;
+
+	private:
+		std::vector<uint8_t> load() const;
+		bool isCompatible(const std::vector<uint8_t>& data) const;
+
+	private:
+		const Device& device;
+		const std::string path;
+		VkPipelineCache cache;
+		bool warm;
+	};
+}
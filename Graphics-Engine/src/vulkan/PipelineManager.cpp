@@ -0,0 +1,586 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include "PipelineManager.hpp"
+#include "PipelineCache.hpp"
+#include "LayoutCache.hpp"
+#include "TextureTable.hpp"
+#include "Shader.hpp"
+#include "Buffer.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	static_assert(sizeof(PipelineState) == sizeof(VkRenderPass) + 16, "pipeline state must not have padding, it is hashed as bytes");
+
+	bool PipelineState::operator==(const PipelineState& other) const noexcept
+	{
+		return memcmp(this, &other, sizeof(PipelineState)) == 0;
+	}
+
+	bool PipelineState::operator!=(const PipelineState& other) const noexcept
+	{
+		return !(*this == other);
+	}
+
+	//fnv-1a over the bytes of the state
+	size_t PipelineStateHash::operator()(const PipelineState& state) const noexcept
+	{
+		const auto* bytes = reinterpret_cast<const uint8_t*>(&state);
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < sizeof(PipelineState); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+
+	//file of the prewarm list, the states follow with their render pass zeroed
+	struct PrewarmHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t stateSize;
+		uint32_t stateCount;
+	};
+
+	constexpr uint32_t prewarmMagic = 0x57525050; //"PPRW"
+	constexpr uint32_t prewarmVersion = 2;
+
+	namespace
+	{
+		//states from the prewarm file are checked before they reach the driver, the program is checked once it is added
+		bool isValidState(const PipelineState& state) noexcept
+		{
+			const uint8_t padding[sizeof(state.padding)]{};
+			return state.topology <= VK_PRIMITIVE_TOPOLOGY_PATCH_LIST &&
+				state.cullMode <= VK_CULL_MODE_FRONT_AND_BACK &&
+				state.frontFace <= VK_FRONT_FACE_CLOCKWISE &&
+				state.depthCompare <= VK_COMPARE_OP_ALWAYS &&
+				state.blendMode <= BlendMode::Additive &&
+				(state.depthFlags & ~(PipelineState::depthTest | PipelineState::depthWrite)) == 0 &&
+				(state.shaderFeatures & ~(PipelineState::texturing | PipelineState::vertexColor)) == 0 &&
+				state.lightingModel <= LightingModel::BlinnPhong &&
+				memcmp(state.padding, padding, sizeof(padding)) == 0;
+		}
+	}
+
+	PipelineManager::PipelineManager(const Device& device, VkPipelineLayout pipelineLayout, const std::string& prewarmPath, uint32_t threadCount)
+		:device(device), pipelineLayout(pipelineLayout), prewarmPath(prewarmPath), prewarmRenderPass(VK_NULL_HANDLE), pendingCount(0),
+		updateCount(0), threadPool(threadCount)
+	{
+		addProgram("vert.spv", "frag.spv");
+		loadPrewarmList();
+	}
+
+	//compiles still running have to land before their pipelines can be destroyed
+	PipelineManager::~PipelineManager()
+	{
+		for (auto& [state, entry] : pipelines)
+		{
+			if (entry.compiling.valid())
+			{
+				try
+				{
+					entry.pipeline = entry.compiling.get();
+				}
+				catch (const std::exception& error)
+				{
+					LOG_WARNING(std::string("background pipeline compile failed: ") + error.what());
+				}
+			}
+
+			if (entry.reloading.valid())
+			{
+				try
+				{
+					retiredPipelines.push_back({ entry.reloading.get(), 0 });
+				}
+				catch (const std::exception&)
+				{
+				}
+			}
+		}
+
+		try
+		{
+			savePrewarmList();
+		}
+		catch (const std::exception& error)
+		{
+			LOG_WARNING(std::string("cant save pipeline prewarm list: ") + error.what());
+		}
+
+		for (auto& [state, entry] : pipelines)
+			vkDestroyPipeline(device.getLogicalDevice(), entry.pipeline, nullptr);
+		for (auto& retired : retiredPipelines)
+			vkDestroyPipeline(device.getLogicalDevice(), retired.pipeline, nullptr);
+	}
+
+	//returns the id states refer to the shader pair by, programs have to be added in the same order every run
+	//for the prewarm list to stay valid
+	uint16_t PipelineManager::addProgram(const std::string& vertexShader, const std::string& fragmentShader)
+	{
+		assert(programs.size() < UINT16_MAX, "cant add more shader programs");
+
+		//the renderer binds its descriptor sets once for all pipelines, so every program has to reflect to the shared layout
+		Vk::Shader vertShader(device.getLogicalDevice(), vertexShader, VK_SHADER_STAGE_VERTEX_BIT);
+		Vk::Shader fragShader(device.getLogicalDevice(), fragmentShader, VK_SHADER_STAGE_FRAGMENT_BIT);
+		ShaderReflection reflection = vertShader.getReflection();
+		reflection.merge(fragShader.getReflection());
+
+		VkPipelineLayout layout = device.getLayoutCache().getPipelineLayout(reflection, { { 0, device.getTextureTable().getLayout() } });
+		assert(layout == pipelineLayout, "cant add shader program, its resources differ from the shared pipeline layout");
+
+		programs.push_back({ vertexShader, fragmentShader, layout });
+		if (prewarmRenderPass != VK_NULL_HANDLE)
+			prewarm(prewarmRenderPass);
+
+		return static_cast<uint16_t>(programs.size() - 1);
+	}
+
+	//waits for the pipeline, meant for startup where there is nothing to fall back to
+	VkPipeline PipelineManager::getPipeline(const PipelineState& state)
+	{
+		VkPipeline pipeline = requestPipeline(state);
+		if (pipeline != VK_NULL_HANDLE)
+			return pipeline;
+
+		Entry& entry = pipelines.at(state);
+		if (entry.compiling.valid())
+			finishCompile(entry);
+
+		assert(!entry.failed, "cant create pipeline, its compile failed");
+		return entry.pipeline;
+	}
+
+	//never waits, the first call starts the compile on a worker and until it is done VK_NULL_HANDLE is returned
+	VkPipeline PipelineManager::requestPipeline(const PipelineState& state)
+	{
+		auto found = pipelines.find(state);
+		Entry& entry = found == pipelines.end() ? startCompile(state) : found->second;
+
+		if (entry.pipeline == VK_NULL_HANDLE && entry.compiling.valid() &&
+			entry.compiling.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			finishCompile(entry);
+
+		return entry.pipeline;
+	}
+
+	//queues every loaded state whose program is known, the rest waits for addProgram
+	void PipelineManager::prewarm(VkRenderPass renderPass)
+	{
+		prewarmRenderPass = renderPass;
+
+		auto known = std::stable_partition(prewarmStates.begin(), prewarmStates.end(), [this](const PipelineState& state) {
+			return state.program >= programs.size();
+		});
+
+		for (auto state = known; state != prewarmStates.end(); ++state)
+		{
+			state->renderPass = renderPass;
+			if (pipelines.find(*state) == pipelines.end())
+				startCompile(*state);
+		}
+
+		prewarmStates.erase(known, prewarmStates.end());
+	}
+
+	//rebuilds every pipeline of the programs using the shader, with whatever code Shader gets for its name now
+	void PipelineManager::reload(const std::string& shader)
+	{
+		size_t count = 0;
+		for (auto& [state, entry] : pipelines)
+		{
+			const Program& program = programs[state.program];
+			if (program.vertexShader != shader && program.fragmentShader != shader)
+				continue;
+
+			//a failed compile gets another try with the new code
+			if (entry.failed)
+			{
+				entry.failed = false;
+				entry.compiling = threadPool.submit([this, state = state, program = program]() {
+					return createPipeline(state, program);
+				});
+				++pendingCount;
+			}
+			else if (entry.reloading.valid())
+				entry.reloadAgain = true;
+			else
+				startReload(state, entry);
+			++count;
+		}
+
+		LOG_INFO(shader + " reloaded, rebuilding " + STR(count) + " pipelines");
+	}
+
+	//called once a frame after its fence, collects finished compiles, prewarmed and reloaded ones included
+	//returns true when any pipeline became ready or was replaced
+	bool PipelineManager::update(uint32_t framesInFlight)
+	{
+		++updateCount;
+		bool finished = updateReloads(framesInFlight);
+		if (pendingCount == 0)
+			return finished;
+
+		for (auto& [state, entry] : pipelines)
+		{
+			if (entry.pipeline == VK_NULL_HANDLE && entry.compiling.valid() &&
+				entry.compiling.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				finishCompile(entry);
+				finished = finished || !entry.failed;
+			}
+		}
+
+		return finished;
+	}
+
+	size_t PipelineManager::getPipelineCount() const noexcept
+	{
+		return pipelines.size();
+	}
+
+	//compiles queued or running, objects using them are drawn with a fallback or not at all
+	size_t PipelineManager::getPendingCount() const noexcept
+	{
+		return pendingCount;
+	}
+
+	void PipelineManager::startReload(const PipelineState& state, Entry& entry)
+	{
+		entry.reloadAgain = false;
+		entry.reloading = threadPool.submit([this, state, program = programs[state.program]]() {
+			return createPipeline(state, program);
+		});
+	}
+
+	//swaps in reloaded pipelines, the replaced ones may still be recorded in frames in flight and are kept until those are done
+	//a reload that fails keeps the old pipeline
+	bool PipelineManager::updateReloads(uint32_t framesInFlight)
+	{
+		auto retired = std::partition(retiredPipelines.begin(), retiredPipelines.end(), [this](const RetiredPipeline& pipeline) {
+			return pipeline.retireUpdate > updateCount;
+		});
+		for (auto pipeline = retired; pipeline != retiredPipelines.end(); ++pipeline)
+			vkDestroyPipeline(device.getLogicalDevice(), pipeline->pipeline, nullptr);
+		retiredPipelines.erase(retired, retiredPipelines.end());
+
+		bool swapped = false;
+		for (auto& [state, entry] : pipelines)
+		{
+			//the first compile has to land first or it would overwrite the reloaded pipeline
+			if (!entry.reloading.valid() || entry.pipeline == VK_NULL_HANDLE ||
+				entry.reloading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				continue;
+
+			try
+			{
+				retiredPipelines.push_back({ entry.pipeline, updateCount + framesInFlight });
+				entry.pipeline = entry.reloading.get();
+				swapped = true;
+			}
+			catch (const std::exception& error)
+			{
+				retiredPipelines.pop_back();
+				LOG_WARNING(std::string("cant reload pipeline: ") + error.what());
+			}
+
+			if (entry.reloadAgain)
+				startReload(state, entry);
+		}
+
+		return swapped;
+	}
+
+	//the worker gets its own copy of the program, addProgram may grow the list meanwhile
+	PipelineManager::Entry& PipelineManager::startCompile(const PipelineState& state)
+	{
+		assert(state.program < programs.size(), "cant create pipeline of unknown shader program");
+
+		Entry& entry = pipelines[state];
+		entry.compiling = threadPool.submit([this, state, program = programs[state.program]]() {
+			return createPipeline(state, program);
+		});
+		++pendingCount;
+
+		return entry;
+	}
+
+	//the compile has to be done or waiting on it is fine, a failed one is never started again on its own
+	void PipelineManager::finishCompile(Entry& entry)
+	{
+		try
+		{
+			entry.pipeline = entry.compiling.get();
+		}
+		catch (const std::exception& error)
+		{
+			LOG_WARNING(std::string("background pipeline compile failed, drawing with the fallback: ") + error.what());
+			entry.failed = true;
+		}
+
+		--pendingCount;
+	}
+
+	VkPipeline PipelineManager::createPipeline(const PipelineState& state, const Program& program) const
+	{
+		Vk::Shader vertShader(device.getLogicalDevice(), program.vertexShader, VK_SHADER_STAGE_VERTEX_BIT);
+		Vk::Shader fragShader(device.getLogicalDevice(), program.fragmentShader, VK_SHADER_STAGE_FRAGMENT_BIT);
+		//constant ids as declared in the shaders, both stages get all of them and use what they declare
+		std::array<uint32_t, 3> specializationData = getSpecializationData(state);
+		std::array<VkSpecializationMapEntry, 3> specializationEntries{};
+		for (uint32_t i = 0; i < specializationEntries.size(); ++i)
+			specializationEntries[i] = { i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t) };
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = sizeof(specializationData);
+		specializationInfo.pData = specializationData.data();
+
+		std::array shaderStages { vertShader.getCreateInfo(), fragShader.getCreateInfo() };
+		for (auto& stage : shaderStages)
+			stage.pSpecializationInfo = &specializationInfo;
+
+		auto bindingDescriptions = Vertex::getBindingDescriptions();
+		auto attributeDescriptions = getAttributeDescriptions(vertShader.getReflection());
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = static_cast<VkPrimitiveTopology>(state.topology);
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		VkDynamicState dynamicStateEnables[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
+		dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicStateInfo.pDynamicStates = dynamicStateEnables;
+		dynamicStateInfo.dynamicStateCount = 2;
+		dynamicStateInfo.flags = 0;
+
+		VkPipelineViewportStateCreateInfo viewportState{};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.pViewports = nullptr;
+		viewportState.scissorCount = 1;
+		viewportState.pScissors = nullptr;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = static_cast<VkCullModeFlags>(state.cullMode);
+		rasterizer.frontFace = static_cast<VkFrontFace>(state.frontFace);
+		rasterizer.depthBiasEnable = VK_FALSE;
+		rasterizer.depthBiasConstantFactor = 0.0f;
+		rasterizer.depthBiasClamp = 0.0f;
+		rasterizer.depthBiasSlopeFactor = 0.0f;
+
+		VkPipelineMultisampleStateCreateInfo multisampling{};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		multisampling.minSampleShading = 1.0f;
+		multisampling.pSampleMask = nullptr;
+		multisampling.alphaToCoverageEnable = VK_FALSE;
+		multisampling.alphaToOneEnable = VK_FALSE;
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = state.blendMode == BlendMode::Opaque ? VK_FALSE : VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		if (state.blendMode == BlendMode::Alpha)
+		{
+			colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+			colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		}
+		else if (state.blendMode == BlendMode::Additive)
+		{
+			colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		}
+
+		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+		colorBlending.blendConstants[0] = 0.0f;
+		colorBlending.blendConstants[1] = 0.0f;
+		colorBlending.blendConstants[2] = 0.0f;
+		colorBlending.blendConstants[3] = 0.0f;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencilInfo{};
+		depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencilInfo.depthTestEnable = (state.depthFlags & PipelineState::depthTest) ? VK_TRUE : VK_FALSE;
+		depthStencilInfo.depthWriteEnable = (state.depthFlags & PipelineState::depthWrite) ? VK_TRUE : VK_FALSE;
+		depthStencilInfo.depthCompareOp = static_cast<VkCompareOp>(state.depthCompare);
+		depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
+		depthStencilInfo.minDepthBounds = 0.0f;
+		depthStencilInfo.maxDepthBounds = 1.0f;
+		depthStencilInfo.stencilTestEnable = VK_FALSE;
+		depthStencilInfo.front = {};
+		depthStencilInfo.back = {};
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+		pipelineInfo.pStages = shaderStages.data();
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencilInfo;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicStateInfo;
+		pipelineInfo.layout = program.layout;
+		pipelineInfo.renderPass = state.renderPass;
+		pipelineInfo.subpass = 0;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		//most of the startup cost is the driver compiling shaders, a warm cache skips it
+		const PipelineCache& pipelineCache = device.getPipelineCache();
+		auto start = std::chrono::high_resolution_clock::now();
+
+		VkPipeline pipeline;
+		assert(vkCreateGraphicsPipelines(device.getLogicalDevice(), pipelineCache.getCache(), 1, &pipelineInfo, nullptr, &pipeline) == VK_SUCCESS, "cant create pipeline");
+
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		LOG_INFO("graphics pipeline created in " + STR(milliseconds) + " ms with a " + (pipelineCache.isWarm() ? "warm" : "cold") + " cache");
+
+		return pipeline;
+	}
+
+	//only the vertex attributes the shader reads, each one has to be in the vertex with the format the shader expects
+	std::vector<VkVertexInputAttributeDescription> PipelineManager::getAttributeDescriptions(const ShaderReflection& reflection)
+	{
+		auto vertexAttributes = Vertex::getAttributeDescriptions();
+
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		for (const ShaderInput& input : reflection.inputs)
+		{
+			auto found = std::find_if(vertexAttributes.begin(), vertexAttributes.end(), [&input](const VkVertexInputAttributeDescription& attribute) {
+				return attribute.location == input.location;
+			});
+
+			assert(found != vertexAttributes.end(), "cant create pipeline, shader reads vertex input the vertex doesnt have");
+			assert(found->format == input.format, "cant create pipeline, vertex input format differs from the shader");
+			attributeDescriptions.push_back(*found);
+		}
+
+		return attributeDescriptions;
+	}
+
+	//values of constant_id 0, 1 and 2, bools are 32 bit in spir-v
+	std::array<uint32_t, 3> PipelineManager::getSpecializationData(const PipelineState& state)
+	{
+		std::array<uint32_t, 3> data{};
+		data[0] = (state.shaderFeatures & PipelineState::texturing) ? VK_TRUE : VK_FALSE;
+		data[1] = (state.shaderFeatures & PipelineState::vertexColor) ? VK_TRUE : VK_FALSE;
+		data[2] = static_cast<uint32_t>(state.lightingModel);
+		return data;
+	}
+
+	//a missing or foreign file only means nothing is prewarmed
+	void PipelineManager::loadPrewarmList()
+	{
+		std::ifstream file(prewarmPath, std::ios::binary);
+		if (!file.is_open())
+			return;
+
+		PrewarmHeader header{};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!file.good() || header.magic != prewarmMagic || header.version != prewarmVersion || header.stateSize != sizeof(PipelineState))
+		{
+			LOG_WARNING("pipeline prewarm list is not usable, ignoring it");
+			return;
+		}
+
+		//the count is checked against the file before anything is allocated for it
+		std::error_code error;
+		const uint64_t fileSize = std::filesystem::file_size(prewarmPath, error);
+		if (error || header.stateCount > (fileSize - sizeof(header)) / sizeof(PipelineState))
+		{
+			LOG_WARNING("pipeline prewarm list is truncated, ignoring it");
+			return;
+		}
+
+		prewarmStates.resize(header.stateCount);
+		file.read(reinterpret_cast<char*>(prewarmStates.data()), static_cast<std::streamsize>(sizeof(PipelineState) * prewarmStates.size()));
+		if (!file.good())
+		{
+			LOG_WARNING("pipeline prewarm list is truncated, ignoring it");
+			prewarmStates.clear();
+			return;
+		}
+
+		auto invalid = std::remove_if(prewarmStates.begin(), prewarmStates.end(), [](const PipelineState& state) {
+			return !isValidState(state);
+		});
+		if (invalid != prewarmStates.end())
+		{
+			LOG_WARNING("pipeline prewarm list has " + STR(prewarmStates.end() - invalid) + " invalid states, skipping them");
+			prewarmStates.erase(invalid, prewarmStates.end());
+		}
+
+		LOG_INFO("pipeline prewarm list has " + STR(prewarmStates.size()) + " states");
+	}
+
+	//every state that compiled this run plus loaded ones that never got to it, written like the pipeline cache
+	void PipelineManager::savePrewarmList() const
+	{
+		std::vector<PipelineState> states = prewarmStates;
+		for (const auto& [state, entry] : pipelines)
+		{
+			if (entry.pipeline != VK_NULL_HANDLE)
+				states.push_back(state);
+		}
+
+		for (auto& state : states)
+			state.renderPass = VK_NULL_HANDLE;
+		std::sort(states.begin(), states.end(), [](const PipelineState& a, const PipelineState& b) {
+			return memcmp(&a, &b, sizeof(PipelineState)) < 0;
+		});
+		states.erase(std::unique(states.begin(), states.end()), states.end());
+
+		PrewarmHeader header{ prewarmMagic, prewarmVersion, sizeof(PipelineState), static_cast<uint32_t>(states.size()) };
+
+		const std::string temporaryPath = prewarmPath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			assert(file.is_open(), "cant create pipeline prewarm file");
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(states.data()), static_cast<std::streamsize>(sizeof(PipelineState) * states.size()));
+			file.flush();
+			assert(file.good(), "cant write pipeline prewarm file");
+		}
+
+		std::filesystem::rename(temporaryPath, prewarmPath);
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <future>
+#include "Device.hpp"
+#include "ShaderReflection.hpp"
+#include "../utils/ThreadPool.hpp"
+
+namespace Vk
+{
+	enum class BlendMode : uint8_t
+	{
+		Opaque,
+		Alpha,
+		Additive
+	};
+
+	//lighting of the default fragment shader, faces are lit flat by a fixed directional light
+	enum class LightingModel : uint8_t
+	{
+		Unlit,
+		Lambert,
+		BlinnPhong
+	};
+
+	//everything a graphics pipeline of the scene can differ in, small enough to be hashed and compared as a whole
+	//the render pass is filled in by the renderer, objects only pick the rest
+	//shader features and lighting are specialization constants, every combination is its own pipeline with the rest compiled out
+	struct PipelineState
+	{
+		static constexpr uint8_t depthTest = 1 << 0;
+		static constexpr uint8_t depthWrite = 1 << 1;
+
+		static constexpr uint8_t texturing = 1 << 0;
+		static constexpr uint8_t vertexColor = 1 << 1;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint16_t program = 0; //shader pair from PipelineManager::addProgram, zero is the default one
+		uint8_t topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		uint8_t cullMode = VK_CULL_MODE_NONE;
+		uint8_t frontFace = VK_FRONT_FACE_CLOCKWISE;
+		uint8_t depthCompare = VK_COMPARE_OP_LESS;
+		BlendMode blendMode = BlendMode::Opaque;
+		uint8_t depthFlags = depthTest | depthWrite;
+		uint8_t shaderFeatures = texturing;
+		LightingModel lightingModel = LightingModel::Unlit;
+		uint8_t padding[6]{};
+
+		bool operator==(const PipelineState& other) const noexcept;
+		bool operator!=(const PipelineState& other) const noexcept;
+	};
+
+	struct PipelineStateHash
+	{
+		size_t operator()(const PipelineState& state) const noexcept;
+	};
+
+	//compiles a graphics pipeline on a worker thread the first time a state is asked for and keeps it for the rest of the run
+	//every pipeline shares one layout, so descriptor sets stay bound across pipeline switches
+	//states used in a run are written to the prewarm file and compiled right at startup of the next one
+	//reloaded shaders rebuild their pipelines the same way, the old ones are used until the new ones are done
+	//used from the render thread only, the workers just compile
+	class PipelineManager
+	{
+	public:
+		explicit PipelineManager(const Device& device, VkPipelineLayout pipelineLayout,
+			const std::string& prewarmPath = "pipelines.prewarm", uint32_t threadCount = 2);
+		~PipelineManager();
+
+		PipelineManager(const PipelineManager&) = delete;
+		PipelineManager& operator=(const PipelineManager&) = delete;
+
+		uint16_t addProgram(const std::string& vertexShader, const std::string& fragmentShader);
+		VkPipeline getPipeline(const PipelineState& state);
+		VkPipeline requestPipeline(const PipelineState& state);
+		void prewarm(VkRenderPass renderPass);
+		void reload(const std::string& shader);
+		bool update(uint32_t framesInFlight);
+		size_t getPipelineCount() const noexcept;
+		size_t getPendingCount() const noexcept;
+
+	private:
+		struct Program
+		{
+			std::string vertexShader;
+			std::string fragmentShader;
+			VkPipelineLayout layout; //from the layout cache, the same for every program
+		};
+
+		struct Entry
+		{
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			std::future<VkPipeline> compiling;
+			std::future<VkPipeline> reloading; //replaces pipeline once it is done
+			bool reloadAgain = false; //shader changed again while reloading
+			bool failed = false; //compile threw, the state is drawn with the fallback until its shaders are reloaded
+		};
+
+		//replaced pipeline, destroyed once no frame in flight can still use it
+		struct RetiredPipeline
+		{
+			VkPipeline pipeline;
+			uint64_t retireUpdate;
+		};
+
+		Entry& startCompile(const PipelineState& state);
+		void finishCompile(Entry& entry);
+		void startReload(const PipelineState& state, Entry& entry);
+		bool updateReloads(uint32_t framesInFlight);
+		VkPipeline createPipeline(const PipelineState& state, const Program& program) const;
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(const ShaderReflection& reflection);
+		static std::array<uint32_t, 3> getSpecializationData(const PipelineState& state);
+		void loadPrewarmList();
+		void savePrewarmList() const;
+
+	private:
+		const Device& device;
+		const VkPipelineLayout pipelineLayout;
+		const std::string prewarmPath;
+		std::vector<Program> programs;
+		std::unordered_map<PipelineState, Entry, PipelineStateHash> pipelines;
+		std::vector<PipelineState> prewarmStates; //loaded from the file, waiting for their render pass or program
+		VkRenderPass prewarmRenderPass;
+		size_t pendingCount;
+		std::vector<RetiredPipeline> retiredPipelines;
+		uint64_t updateCount;
+		ThreadPool threadPool;
+	};
+}
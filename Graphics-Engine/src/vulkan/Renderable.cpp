@@ -1,11 +1,20 @@
+#include <algorithm>
 #include "Renderable.hpp"
+#include "TextureTable.hpp"
 #include "../utils/Logger.hpp"
 
 namespace Vk
 {
-	Renderable::Renderable(const Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, 
-		const VkCommandPool commandPool)
-		:vertexBuffer(std::make_unique<Buffer>(device, vertices, commandPool)), indexBuffer(std::make_unique<Buffer>(device, indices, commandPool))
+	std::atomic<uint64_t> Renderable::changeCount{ 0 };
+
+	Renderable::Renderable(const Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		:mesh(device.getGeometryBuffer().add(vertices, indices))
+	{
+
+	}
+
+	Renderable::Renderable(const Mesh& mesh)
+		:mesh(mesh)
 	{
 
 	}
@@ -20,14 +29,53 @@ namespace Vk
 
 	}
 
-	const Buffer& Renderable::getVertexBuffer() const noexcept
+	const Mesh& Renderable::getMesh() const noexcept
+	{
+		return mesh;
+	}
+
+	UploadToken Renderable::getUploadToken() const noexcept
+	{
+		return mesh.uploadToken;
+	}
+
+	uint32_t Renderable::getTextureIndex() const
+	{
+		return TextureTable::fallbackIndex;
+	}
+
+	const Transform& Renderable::getTransform() const noexcept
+	{
+		return transform;
+	}
+
+	void Renderable::setTransform(const Transform& transform) noexcept
+	{
+		this->transform = transform;
+		++changeCount;
+	}
+
+	void Renderable::setPosition(const glm::vec3& position) noexcept
+	{
+		transform.position = position;
+		++changeCount;
+	}
+
+	const PipelineState& Renderable::getPipelineState() const noexcept
+	{
+		return pipelineState;
+	}
+
+	void Renderable::setPipelineState(const PipelineState& state) noexcept
 	{
-		return *vertexBuffer;
+		pipelineState = state;
+		++changeCount;
 	}
 
-	const Buffer& Renderable::getIndexBuffer() const noexcept
+	//bumped by every setter of any object, the renderer compares it to the count its draw list was built with
+	uint64_t Renderable::getChangeCount() noexcept
 	{
-		return *indexBuffer;
+		return changeCount.load();
 	}
 
 	glm::mat4 Transform::getModel() const noexcept
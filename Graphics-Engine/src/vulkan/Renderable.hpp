@@ -2,9 +2,12 @@
 
 #include <string>
 #include <memory>
+#include <atomic>
 #include <glm/gtx/transform.hpp>
 #include "Buffer.hpp"
+#include "GeometryBuffer.hpp"
 #include "Camera.hpp"
+#include "PipelineManager.hpp"
 
 namespace Vk
 {
@@ -27,19 +30,31 @@ namespace Vk
 		Renderable(Renderable&&) = default;
 		Renderable& operator=(const Renderable&) = delete;
 
-		virtual void draw(VkCommandBuffer commandBuffer, const VkPipelineLayout pipelineLayout, const Camera& camera) const = 0;
-		const Buffer& getVertexBuffer() const noexcept;
-		const Buffer& getIndexBuffer() const noexcept;
+		const Mesh& getMesh() const noexcept;
+		virtual UploadToken getUploadToken() const noexcept;
+		virtual uint32_t getTextureIndex() const;
+		const Transform& getTransform() const noexcept;
+		void setTransform(const Transform& transform) noexcept;
+		void setPosition(const glm::vec3& position) noexcept;
+		const PipelineState& getPipelineState() const noexcept;
+		void setPipelineState(const PipelineState& state) noexcept;
 
-	public:
-		mutable Transform transform;
+		static uint64_t getChangeCount() noexcept;
 
 	protected:
-		Renderable(const Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
-			const VkCommandPool commandPool);
+		Renderable(const Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		Renderable(const Mesh& mesh);
 		Renderable();
 
 	protected:
-		std::unique_ptr<Buffer> vertexBuffer, indexBuffer;
+		//objects with the same mesh are drawn by the renderer as one instanced indirect draw
+		Mesh mesh;
+		//changed only through the setters once the object is drawn, they tell the renderer to build the draw list again
+		Transform transform;
+		//objects are drawn sorted by it, each distinct state costs one pipeline bind per frame
+		PipelineState pipelineState;
+
+	private:
+		static std::atomic<uint64_t> changeCount;
 	};
 }
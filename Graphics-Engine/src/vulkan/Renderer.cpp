@@ -1,6 +1,12 @@
+#include <cstring>
+#include <numeric>
+#include <algorithm>
 #include "Renderer.hpp"
 #include "../utils/assert.hpp"
 #include "Cube.hpp"
+#include "StagingRing.hpp"
+#include "UploadContext.hpp"
+#include "TextureTable.hpp"
 #include "../input/KeyboardMouse.hpp"
 #include "../utils/radom.hpp"
 
@@ -12,13 +18,17 @@ namespace Vk
 		const std::vector<std::shared_ptr<Renderable>>& renderObjects
 	)
 		:window(window), device(device), swapChain(swapChain), pipeline(pipeline), 
-		maxFramesInFlight(maxFramesInFlight), currentFrame(0), renderObjects(renderObjects), images(images)
+		maxFramesInFlight(maxFramesInFlight), currentFrame(0), frameCount(0), renderObjects(renderObjects), images(images), textureLoader(device),
+		depthPyramid(device, swapChain), frustumCuller(device, maxFramesInFlight),
+		commandRecorder(device, maxFramesInFlight), gpuProfiler(device, maxFramesInFlight), sceneVersion(1), builtSceneVersion(0), listVersion(0), builtChangeCount(0), sceneSettled(false),
+		builtViewProjection(1.0f), cpuCulling(false), occlusionCulling(true)
 	{
 		init();
 	}
 
 	Renderer::~Renderer()
 	{
+		destroyRetiredPipelines(true);
 		vkDestroyDescriptorPool(device.getLogicalDevice(), descriptorPool, nullptr);
 		for (size_t i = 0; i < maxFramesInFlight; ++i)
 		{
@@ -40,14 +50,61 @@ namespace Vk
 		{
 			LOG_INFO("window was resized");
 			swapChain.recreateSwapChain(pipeline.getRenderPass());
+			depthPyramid.recreate();
+			frustumCuller.setDepthPyramid(depthPyramid);
+			invalidateCommandBuffers();
 			window.resetWasResized();
 			return;
 		}
 
+		//timestamps of the last submission of this frame, its fence just signaled
+		gpuProfiler.collect(currentFrame);
+
         vkResetFences(device.getLogicalDevice(), 1, &inFlightFences[currentFrame]);
 
-        vkResetCommandBuffer(commandBuffers[currentFrame], 0);
-        recordCommandBuffer(commandBuffers[currentFrame], imageIndex, camera);
+		//records uploads of textures decoded since the last frame
+		textureLoader.update();
+
+		//submits what was recorded since the last frame and hands finished uploads to the graphics queue
+		auto& uploadContext = device.getUploadContext();
+		const UploadToken uploaded = uploadContext.flush();
+
+		//pipelines compiled in the background since the last frame replace their fallbacks or the pipelines of reloaded shaders
+		auto& pipelineManager = pipeline.getManager();
+		destroyRetiredPipelines();
+		if (shaderWatcher)
+		{
+			for (const std::string& shader : shaderWatcher->takeChanged())
+			{
+				if (shader == "cull.spv" || shader == "pyramid.spv")
+					reloadComputeShader(shader);
+				else
+					pipelineManager.reload(shader);
+			}
+		}
+		if (pipelineManager.update(maxFramesInFlight))
+			markSceneChanged();
+
+		//camera data lives in the uniform buffer, so it never forces the command buffers to be recorded again
+		updateFrameData(camera);
+
+		//the draw list is only rebuilt when something changed, until every upload has landed it is rebuilt each frame
+		//since objects and textures become ready on their own
+		const bool settled = uploadContext.isComplete(uploaded) && textureLoader.getPendingCount() == 0;
+		if (isSceneChanged(camera))
+		{
+			updateInstances(camera);
+			sceneSettled = settled;
+		}
+
+		if (reserveFrameBuffers(currentFrame, static_cast<uint32_t>(drawObjects.size()), static_cast<uint32_t>(drawCommands.size())))
+			invalidateFrame(currentFrame);
+
+		//the culling pass counts the instances up from zero every frame
+		memcpy(drawCommandBuffers[currentFrame]->getMappedData(), drawCommands.data(), sizeof(VkDrawIndexedIndirectCommand) * drawCommands.size());
+		frustumCuller.update(currentFrame, camera, static_cast<uint32_t>(drawObjects.size()), depthPyramid, occlusionCulling);
+
+		VkCommandBuffer commandBuffer = getCommandBuffer(imageIndex);
 
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -58,25 +115,60 @@ namespace Vk
         submitInfo.pWaitDstStageMask = waitStages;
 
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
+        submitInfo.pCommandBuffers = &commandBuffer;
 
         submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrame];
 
 		assert(vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) == VK_SUCCESS, "cant submit command buffer");
+		gpuProfiler.submitted(currentFrame);
 
 		swapChain.presentImage(imageIndex, &renderFinishedSemaphores[currentFrame]);
+		device.getStagingRing().endFrame();
+		device.getTextureTable().endFrame();
 
 		currentFrame = (currentFrame + 1) % maxFramesInFlight;
+		++frameCount;
 	}
 
-	void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const Camera& camera)
+	//returns whether the buffer can be submitted again as long as the draw list stays the same
+	bool Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
 	{
 		VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
 		assert(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS, "cant start command buffer");
+		gpuProfiler.begin(commandBuffer, currentFrame);
+
+		bool reusable = true;
+		{
+			GpuProfiler::Scope frameScope(gpuProfiler, commandBuffer, "frame");
+
+			//objects outside of the frustum or hidden behind last frame's depth are dropped from the draw commands before anything is rasterized
+			reusable = !depthPyramid.prepare(commandBuffer);
+			{
+				GpuProfiler::Scope cullScope(gpuProfiler, commandBuffer, "culling");
+				frustumCuller.record(commandBuffer, currentFrame, static_cast<uint32_t>(drawObjects.size()));
+			}
 
+			{
+				GpuProfiler::Scope sceneScope(gpuProfiler, commandBuffer, "scene");
+				recordScene(commandBuffer, imageIndex);
+			}
+
+			//the depth just rendered becomes the occluders of the next frame
+			{
+				GpuProfiler::Scope pyramidScope(gpuProfiler, commandBuffer, "depth pyramid");
+				depthPyramid.build(commandBuffer, imageIndex);
+			}
+		}
+
+		assert(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "cant end command buffer");
+		return reusable;
+	}
+
+	void Renderer::recordScene(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = pipeline.getRenderPass();
@@ -90,7 +182,49 @@ namespace Vk
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		//the draws are recorded into secondary buffers on the worker threads
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = pipeline.getRenderPass();
+		inheritanceInfo.subpass = 0;
+		//left out so the same secondary buffers serve every swap chain image
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		if (secondaryVersions[currentFrame] != listVersion)
+		{
+			secondaryBuffers[currentFrame] = commandRecorder.record(currentFrame, inheritanceInfo, static_cast<uint32_t>(drawObjects.size()),
+				[this](VkCommandBuffer secondaryBuffer, uint32_t worker, uint32_t workerCount) { recordObjects(secondaryBuffer, worker, workerCount); });
+			secondaryVersions[currentFrame] = listVersion;
+		}
+
+		const auto& frameSecondaryBuffers = secondaryBuffers[currentFrame];
+		if (!frameSecondaryBuffers.empty())
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(frameSecondaryBuffers.size()), frameSecondaryBuffers.data());
+
+        vkCmdEndRenderPass(commandBuffer);
+	}
+
+	//one worker's share of the render list, it writes the data of its objects for the culling pass
+	//and draws its part of the indirect commands, secondary buffers inherit no state so everything is bound again
+	void Renderer::recordObjects(VkCommandBuffer commandBuffer, uint32_t worker, uint32_t workerCount)
+	{
+		auto* objects = static_cast<ObjectData*>(objectBuffers[currentFrame]->getMappedData());
+		const auto [firstObject, objectCount] = CommandRecorder::getRange(static_cast<uint32_t>(drawObjects.size()), worker, workerCount);
+		for (uint32_t i = firstObject; i < firstObject + objectCount; ++i)
+		{
+			const auto& [commandIndex, object] = drawObjects[i];
+			ObjectData& objectData = objects[i];
+			objectData.instance.setModel(object->getTransform().getModel());
+			objectData.instance.textureIndex = drawTextures[i];
+			objectData.boundingSphere = object->getMesh().boundingSphere;
+			objectData.drawCommand = commandIndex;
+		}
+
+		const auto [firstCommand, commandCount] = CommandRecorder::getRange(static_cast<uint32_t>(drawCommands.size()), worker, workerCount);
+		if (commandCount == 0)
+			return;
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -109,47 +243,45 @@ namespace Vk
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipeline());
-
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), 0, 1, &descriptorSets[currentFrame], 0, nullptr);
-
-		//VkBuffer vertexBuffers[] = {vertexBuffer->getBuffer()};
-		//VkDeviceSize offsets[] = {0};
-		//vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		//every texture is in the one table, objects only pick their index
+		std::array<VkDescriptorSet, 2> sets = { device.getTextureTable().getDescriptorSet(), descriptorSets[currentFrame] };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
 
-		//vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-		//PushConstant push{};
-		//push.model = glm::scale(push.model, glm::vec3(0.3f, 0.3, 0.3));
-		//push.model = glm::translate(push.model, glm::vec3(1.0f, 0, 0));
-		//push.model = glm::rotate(push.model, glm::radians(45.0f), glm::vec3(0, 0, 1));
-		//vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstant), &push);
-
-        //vkCmdDrawIndexed(commandBuffer, indexBuffer->getVertexCount(), 1, 0, 0, 0);
-
-		for (auto& object : renderObjects)
+		//every mesh lives in the shared geometry buffer, so each run of commands with the same pipeline is one indirect draw
+		//commands left with no visible instances cost nothing
+		device.getGeometryBuffer().bind(commandBuffer);
+		const uint32_t lastCommand = firstCommand + commandCount;
+		for (uint32_t first = firstCommand; first < lastCommand;)
 		{
-			object->draw(commandBuffer, pipeline.getLayout(), camera);
+			uint32_t last = first + 1;
+			while (last < lastCommand && drawPipelines[last] == drawPipelines[first])
+				++last;
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipelines[first]);
+			vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffers[currentFrame]->getBuffer(), first * sizeof(VkDrawIndexedIndirectCommand),
+				last - first, sizeof(VkDrawIndexedIndirectCommand));
+			first = last;
 		}
-
-        vkCmdEndRenderPass(commandBuffer);
-
-		assert(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "cant end command buffer");
 	}
 
 	void Renderer::init()
 	{
 		createCommandPool();
 
-			images.push_back(std::make_unique<Image>(device, "C:/Users/gewes/Pictures/mai.jpg", glm::vec2{ 1.0f }, commandPool));
-			images[0]->transform.position.z += 2;
+		createPlaceholder();
 
-		renderObjects.push_back(images[0]);
+			auto image = loadImage("C:/Users/gewes/Pictures/mai.jpg", glm::vec2{ 1.0f });
+			image->setPosition(image->getTransform().position + glm::vec3{ 0.0f, 0.0f, 2.0f });
 
 		createCommandBuffers();
 		createSyncObjects();
+		createUniformBuffers();
 		createDescriptorPool();
 		createDescriptorSets();
+		frustumCuller.setDepthPyramid(depthPyramid);
+
+		LOG_INFO(std::string("cpu culling kernel: ") + CpuCuller::getKernelName(cpuCuller.getKernel()));
+		LOG_INFO("recording on " + STR(commandRecorder.getThreadCount()) + " threads");
 	}
 
 	void Renderer::createCommandPool()
@@ -166,13 +298,16 @@ namespace Vk
 
 	void Renderer::createCommandBuffers()
 	{
-		commandBuffers.resize(maxFramesInFlight);
+		commandBuffers.resize(maxFramesInFlight * swapChain.getFrameBuffers().size());
+		commandBufferVersions.assign(commandBuffers.size(), 0);
+		secondaryBuffers.resize(maxFramesInFlight);
+		secondaryVersions.assign(maxFramesInFlight, 0);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = commandPool;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = maxFramesInFlight;
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
 		assert(vkAllocateCommandBuffers(device.getLogicalDevice(), &allocInfo, commandBuffers.data()) == VK_SUCCESS, "cant allocate command buffer");
 	}
@@ -183,13 +318,66 @@ namespace Vk
 
 		for (size_t i = 0; i < maxFramesInFlight; ++i)
 		{
-			uniformBuffers.push_back(std::make_unique<Buffer>(device, 128, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+			uniformBuffers.push_back(std::make_unique<Buffer>(device, sizeof(FrameData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
 		}
 	}
 
 	void Renderer::addRenderObject(std::shared_ptr<Renderable> object)
 	{
 		renderObjects.push_back(std::move(object));
+		markSceneChanged();
+	}
+
+	//for changes the renderable setters dont see, like the mesh or texture of an object
+	void Renderer::markSceneChanged() noexcept
+	{
+		++sceneVersion;
+	}
+
+	//culls on the cpu with the widest simd kernel available instead of leaving everything to the compute pass
+	void Renderer::setCpuCulling(bool enabled) noexcept
+	{
+		cpuCulling = enabled;
+		markSceneChanged();
+	}
+
+	//tests objects against the depth pyramid of the previous frame, objects appearing from behind an occluder pop in one frame late
+	void Renderer::setOcclusionCulling(bool enabled) noexcept
+	{
+		occlusionCulling = enabled;
+	}
+
+	//development only, edits to the default shaders in the directory are recompiled and swapped in without a restart
+	void Renderer::enableShaderReload(const std::string& sourceDirectory)
+	{
+		shaderWatcher = std::make_unique<ShaderWatcher>(sourceDirectory);
+		shaderWatcher->watch("shader.vert", "vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+		shaderWatcher->watch("shader.frag", "frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+		shaderWatcher->watch("cull.comp", "cull.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		shaderWatcher->watch("pyramid.comp", "pyramid.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+	}
+
+	//counters of the culling pass, a few frames old since they are never waited on
+	const CullStats& Renderer::getCullStats() const noexcept
+	{
+		return frustumCuller.getStats();
+	}
+
+	//gpu time of the passes, the newest samples are maxFramesInFlight frames old
+	std::vector<GpuScopeStats> Renderer::getGpuStats() const
+	{
+		return gpuProfiler.getStats();
+	}
+
+	//the image shows the placeholder texture until it is decoded and uploaded
+	std::shared_ptr<Image> Renderer::loadImage(const std::string& path, const glm::vec2& dimensions)
+	{
+		auto image = textureLoader.load(path, dimensions);
+		images.push_back(image);
+		renderObjects.push_back(image);
+		markSceneChanged();
+
+		return image;
 	}
 
 	const VkCommandPool Renderer::getCommandPool() const noexcept
@@ -220,14 +408,16 @@ namespace Vk
 
 	void Renderer::createDescriptorPool()
 	{
-		VkDescriptorPoolSize poolSize{};
-		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSize.descriptorCount = static_cast<uint32_t>(maxFramesInFlight);
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[0].descriptorCount = static_cast<uint32_t>(maxFramesInFlight);
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		poolSizes[1].descriptorCount = static_cast<uint32_t>(maxFramesInFlight);
 
 		VkDescriptorPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = 1;
-		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
 		poolInfo.maxSets = static_cast<uint32_t>(maxFramesInFlight);
 
 		assert(vkCreateDescriptorPool(device.getLogicalDevice(), &poolInfo, nullptr, &descriptorPool) == VK_SUCCESS, "cant create descriptro pool");
@@ -247,25 +437,289 @@ namespace Vk
 
 		for (size_t i = 0; i < maxFramesInFlight; ++i)
 		{
-			std::vector<VkDescriptorImageInfo> imageInfos(images.size());
-			std::vector<VkWriteDescriptorSet> descriptorWrites(images.size());
-			
-			for (size_t j = 0; j < images.size(); ++j)
+			VkDescriptorBufferInfo bufferInfo{};
+			bufferInfo.buffer = uniformBuffers[i]->getBuffer();
+			bufferInfo.offset = 0;
+			bufferInfo.range = sizeof(FrameData);
+
+			VkWriteDescriptorSet descriptorWrite{};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = descriptorSets[i];
+			descriptorWrite.dstBinding = 1;
+			descriptorWrite.dstArrayElement = 0;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pBufferInfo = &bufferInfo;
+
+			vkUpdateDescriptorSets(device.getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+		}
+
+		objectBuffers.resize(maxFramesInFlight);
+		instanceBuffers.resize(maxFramesInFlight);
+		drawCommandBuffers.resize(maxFramesInFlight);
+		for (uint32_t i = 0; i < maxFramesInFlight; ++i)
+			reserveFrameBuffers(i, 1024, 64);
+	}
+
+	//the frame fence was waited on so this frame's uniform buffer is free to overwrite
+	void Renderer::updateFrameData(const Camera& camera)
+	{
+		FrameData frameData{};
+		frameData.view = camera.getView();
+		frameData.projection = camera.getProjection();
+		frameData.viewProjection = camera.getViewProjection();
+		frameData.cameraPosition = glm::vec4(camera.position, 1.0f);
+
+		memcpy(uniformBuffers[currentFrame]->getMappedData(), &frameData, sizeof(FrameData));
+	}
+
+	//groups the objects by mesh, writes them into this frame's object buffer and one indirect draw command
+	//per mesh into this frame's draw command buffer, the culling pass then fills in the visible instances
+	void Renderer::updateInstances(const Camera& camera)
+	{
+		drawCommands.clear();
+		drawPipelines.clear();
+		drawObjects.clear();
+		drawTextures.clear();
+		drawCommandIndices.clear();
+		pipelineIndices.clear();
+		candidates.clear();
+
+		auto& uploadContext = device.getUploadContext();
+		for (const auto& object : renderObjects)
+		{
+			//objects still being streamed in are skipped instead of stalling the frame
+			if (uploadContext.isComplete(object->getUploadToken()))
+				candidates.push_back(object.get());
+		}
+
+		//invisible objects are dropped before they are uploaded, the gpu pass then only sees the survivors
+		if (cpuCulling)
+		{
+			cullSpheres.clear();
+			for (const Renderable* object : candidates)
+				cullSpheres.add(CpuCuller::transformSphere(object->getMesh().boundingSphere, object->getTransform().getModel()));
+
+			cpuCuller.cull(camera.getFrustumPlanes(), cullSpheres, visibleCandidates);
+			for (size_t i = 0; i < visibleCandidates.size(); ++i)
+				candidates[i] = candidates[visibleCandidates[i]];
+			candidates.resize(visibleCandidates.size());
+		}
+
+		//one draw command per pipeline and mesh, pipelines are compiled in the background the first time an object asks for their state
+		//until then the object is drawn with the default state of its topology, or skipped when that one isnt ready either
+		auto& pipelineManager = pipeline.getManager();
+		std::vector<uint32_t> commandPipelines; //pipeline index of every draw command
+		for (const Renderable* object : candidates)
+		{
+			PipelineState state = object->getPipelineState();
+			state.renderPass = pipeline.getRenderPass();
+			VkPipeline objectPipeline = pipelineManager.requestPipeline(state);
+			if (objectPipeline == VK_NULL_HANDLE)
 			{
-				imageInfos[j].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageInfos[j].imageView = images[j]->getImageView();
-				imageInfos[j].sampler = images[j]->getSampler();
-			
-				descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descriptorWrites[j].dstSet = descriptorSets[i];
-				descriptorWrites[j].dstBinding = 1;
-				descriptorWrites[j].dstArrayElement = 0;
-				descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				descriptorWrites[j].descriptorCount = 1;
-				descriptorWrites[j].pImageInfo = &imageInfos[j];
+				PipelineState fallback = pipeline.getDefaultState();
+				fallback.topology = state.topology;
+				objectPipeline = pipelineManager.requestPipeline(fallback);
 			}
+			if (objectPipeline == VK_NULL_HANDLE)
+				continue;
+			auto [pipelineIndex, newPipeline] = pipelineIndices.try_emplace(objectPipeline, static_cast<uint32_t>(pipelineIndices.size()));
+
+			const Mesh& mesh = object->getMesh();
+			const uint64_t key = static_cast<uint64_t>(pipelineIndex->second) << 32 | mesh.id;
+			auto [command, inserted] = drawCommandIndices.try_emplace(key, static_cast<uint32_t>(drawCommands.size()));
+			if (inserted)
+			{
+				drawCommands.push_back({ mesh.indexCount, 0, mesh.firstIndex, mesh.vertexOffset, 0 });
+				drawPipelines.push_back(objectPipeline);
+				commandPipelines.push_back(pipelineIndex->second);
+			}
+
+			++drawCommands[command->second].instanceCount;
+			drawObjects.emplace_back(command->second, object);
+			//asking an image whether it is ready polls the upload context, which only the render thread may touch
+			drawTextures.push_back(object->getTextureIndex());
+		}
+
+		//commands of one pipeline next to each other, so the pipeline is bound once for all of them
+		std::vector<uint32_t> order(drawCommands.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&commandPipelines](uint32_t a, uint32_t b) {
+			return commandPipelines[a] < commandPipelines[b];
+		});
+
+		std::vector<uint32_t> sortedIndices(order.size());
+		std::vector<VkDrawIndexedIndirectCommand> sortedCommands(order.size());
+		std::vector<VkPipeline> sortedPipelines(order.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			sortedIndices[order[i]] = i;
+			sortedCommands[i] = drawCommands[order[i]];
+			sortedPipelines[i] = drawPipelines[order[i]];
+		}
+		drawCommands.swap(sortedCommands);
+		drawPipelines.swap(sortedPipelines);
+		for (auto& [commandIndex, object] : drawObjects)
+			commandIndex = sortedIndices[commandIndex];
+
+		uint32_t instanceCount = 0;
+		for (auto& command : drawCommands)
+		{
+			command.firstInstance = instanceCount;
+			instanceCount += command.instanceCount;
+			command.instanceCount = 0;
+		}
+
+		//object data is written by the recording workers
+		builtSceneVersion = sceneVersion;
+		builtChangeCount = Renderable::getChangeCount();
+		builtViewProjection = camera.getViewProjection();
+		++listVersion;
+	}
 
-			vkUpdateDescriptorSets(device.getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	//culling on the cpu bakes the camera into the draw list
+	bool Renderer::isSceneChanged(const Camera& camera) const noexcept
+	{
+		return sceneVersion != builtSceneVersion || Renderable::getChangeCount() != builtChangeCount || !sceneSettled || (cpuCulling && camera.getViewProjection() != builtViewProjection);
+	}
+
+	//records the buffer of this frame and image only when the draw list changed since it was recorded
+	VkCommandBuffer Renderer::getCommandBuffer(uint32_t imageIndex)
+	{
+		const size_t index = currentFrame * swapChain.getFrameBuffers().size() + imageIndex;
+		if (commandBufferVersions[index] != listVersion)
+		{
+			vkResetCommandBuffer(commandBuffers[index], 0);
+			commandBufferVersions[index] = recordCommandBuffer(commandBuffers[index], imageIndex) ? listVersion : 0;
 		}
+
+		return commandBuffers[index];
+	}
+
+	//compute pipelines are compiled right away on the render thread, reloading is development only so the hitch is fine
+	//recorded buffers still dispatch the old pipeline, they are recorded again and the old one lives until its frames finished
+	void Renderer::reloadComputeShader(const std::string& shader)
+	{
+		VkPipeline replaced = shader == "cull.spv" ? frustumCuller.reloadPipeline() : depthPyramid.reloadPipeline();
+		retiredPipelines.push_back({ replaced, frameCount + maxFramesInFlight });
+
+		invalidateCommandBuffers();
+		LOG_INFO(shader + " reloaded, compute pipeline rebuilt");
+	}
+
+	//called after the frame fence, every frame submitted before retireFrame - maxFramesInFlight has finished by then
+	void Renderer::destroyRetiredPipelines(bool all)
+	{
+		auto retired = std::partition(retiredPipelines.begin(), retiredPipelines.end(), [this, all](const RetiredPipeline& pipeline) {
+			return !all && pipeline.retireFrame > frameCount;
+		});
+		for (auto pipeline = retired; pipeline != retiredPipelines.end(); ++pipeline)
+			vkDestroyPipeline(device.getLogicalDevice(), pipeline->pipeline, nullptr);
+		retiredPipelines.erase(retired, retiredPipelines.end());
+	}
+
+	//after the swap chain was recreated, framebuffers, extent and image count may all differ
+	void Renderer::invalidateCommandBuffers()
+	{
+		if (commandBuffers.size() != maxFramesInFlight * swapChain.getFrameBuffers().size())
+		{
+			vkFreeCommandBuffers(device.getLogicalDevice(), commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+			createCommandBuffers();
+		}
+
+		std::fill(commandBufferVersions.begin(), commandBufferVersions.end(), 0);
+		std::fill(secondaryVersions.begin(), secondaryVersions.end(), 0);
+	}
+
+	//the buffers of the frame were reallocated, everything recorded with them is stale
+	void Renderer::invalidateFrame(uint32_t frame)
+	{
+		const size_t imageCount = swapChain.getFrameBuffers().size();
+		std::fill_n(commandBufferVersions.begin() + frame * imageCount, imageCount, 0);
+		secondaryVersions[frame] = 0;
+	}
+
+	//the frame fence was waited on, so its buffers and sets can be replaced
+	//returns true when any of the buffers was reallocated
+	bool Renderer::reserveFrameBuffers(uint32_t frame, uint32_t objectCount, uint32_t drawCount)
+	{
+		const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		bool objectsChanged = reserveBuffer(objectBuffers[frame], sizeof(ObjectData) * static_cast<VkDeviceSize>(objectCount),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		bool instancesChanged = reserveBuffer(instanceBuffers[frame], sizeof(InstanceData) * static_cast<VkDeviceSize>(objectCount),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		bool drawCommandsChanged = reserveBuffer(drawCommandBuffers[frame], sizeof(VkDrawIndexedIndirectCommand) * static_cast<VkDeviceSize>(drawCount),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, hostVisible);
+
+		if (objectsChanged || instancesChanged || drawCommandsChanged)
+			frustumCuller.setBuffers(frame, *objectBuffers[frame], *instanceBuffers[frame], *drawCommandBuffers[frame]);
+
+		if (!instancesChanged)
+			return objectsChanged || drawCommandsChanged;
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = instanceBuffers[frame]->getBuffer();
+		bufferInfo.offset = 0;
+		bufferInfo.range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = descriptorSets[frame];
+		descriptorWrite.dstBinding = 0;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(device.getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+		return true;
+	}
+
+	//grows the buffer to the next power of two step, returns true when it was reallocated
+	bool Renderer::reserveBuffer(std::unique_ptr<Buffer>& buffer, VkDeviceSize requiredSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties)
+	{
+		if (buffer && buffer->getDeviceSize() >= requiredSize)
+			return false;
+
+		VkDeviceSize size = buffer ? buffer->getDeviceSize() : 256;
+		while (size < requiredSize)
+			size *= 2;
+
+		buffer = std::make_unique<Buffer>(device, size, usage, memoryProperties);
+		return true;
+	}
+
+	//small checkerboard drawn in place of textures that are still loading
+	void Renderer::createPlaceholder()
+	{
+		const uint32_t size = 8;
+
+		ImageSource source;
+		source.width = size;
+		source.height = size;
+		source.chain.data.resize(size * size * 4);
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				uint8_t value = ((x / 4 + y / 4) % 2) ? 0xC0 : 0x40;
+				memset(source.chain.data.data() + (y * size + x) * 4, value, 3);
+				source.chain.data[(y * size + x) * 4 + 3] = 0xFF;
+			}
+		}
+
+		source.data = source.chain.data.data();
+		source.size = source.chain.data.size();
+		source.levels = { { size, size, 0, source.chain.data.size() } };
+
+		placeholder = std::make_shared<Image>(device, glm::vec2{ 1.0f });
+		placeholder->upload(source);
+
+		//the placeholder has to be usable from the first frame
+		auto& uploadContext = device.getUploadContext();
+		uploadContext.wait(uploadContext.getToken());
+
+		device.getTextureTable().setFallback(placeholder->getImageView(), placeholder->getSampler());
 	}
 }
@@ -3,13 +3,21 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include "Device.hpp"
 #include "SwapChain.hpp"
 #include "Pipeline.hpp"
 #include "Buffer.hpp"
 #include "Renderable.hpp"
 #include "Cube.hpp"
+#include "FrustumCuller.hpp"
+#include "DepthPyramid.hpp"
+#include "CpuCuller.hpp"
+#include "CommandRecorder.hpp"
+#include "ShaderWatcher.hpp"
+#include "GpuProfiler.hpp"
 #include "../textures/Image.hpp"
+#include "../textures/TextureLoader.hpp"
 
 namespace Vk 
 {
@@ -26,8 +34,15 @@ namespace Vk
 		Renderer& operator=(const Renderer&) = delete;
 
 		void drawFrame(const Camera& camera);
-		void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const Camera& camera);
+		bool recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 		void addRenderObject(std::shared_ptr<Renderable> object);
+		void markSceneChanged() noexcept;
+		void setCpuCulling(bool enabled) noexcept;
+		void setOcclusionCulling(bool enabled) noexcept;
+		void enableShaderReload(const std::string& sourceDirectory);
+		const CullStats& getCullStats() const noexcept;
+		std::vector<GpuScopeStats> getGpuStats() const;
+		std::shared_ptr<Image> loadImage(const std::string& path, const glm::vec2& dimensions);
 		const VkCommandPool getCommandPool() const noexcept;
 
 	private:
@@ -38,6 +53,19 @@ namespace Vk
 		void createSyncObjects();
 		void createDescriptorPool();
 		void createDescriptorSets();
+		void createPlaceholder();
+		void updateFrameData(const Camera& camera);
+		void updateInstances(const Camera& camera);
+		bool isSceneChanged(const Camera& camera) const noexcept;
+		VkCommandBuffer getCommandBuffer(uint32_t imageIndex);
+		void reloadComputeShader(const std::string& shader);
+		void destroyRetiredPipelines(bool all = false);
+		void invalidateCommandBuffers();
+		void invalidateFrame(uint32_t frame);
+		void recordScene(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void recordObjects(VkCommandBuffer commandBuffer, uint32_t worker, uint32_t workerCount);
+		bool reserveFrameBuffers(uint32_t frame, uint32_t objectCount, uint32_t drawCount);
+		bool reserveBuffer(std::unique_ptr<Buffer>& buffer, VkDeviceSize requiredSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties);
 
 	private:
 		const Window& window;
@@ -46,15 +74,53 @@ namespace Vk
 		const Pipeline& pipeline;
 		const uint32_t maxFramesInFlight;
 		uint32_t currentFrame;
+		uint64_t frameCount;
 		VkCommandPool commandPool;
 		VkDescriptorPool descriptorPool;
-		std::vector<VkCommandBuffer> commandBuffers;
+		//primary buffers are kept for every frame in flight and swap chain image and only recorded again when the draw list changed
+		std::vector<VkCommandBuffer> commandBuffers; //frame * image count + image
+		std::vector<uint64_t> commandBufferVersions; //list version each buffer was recorded with, zero to record it again
+		std::vector<std::vector<VkCommandBuffer>> secondaryBuffers;
+		std::vector<uint64_t> secondaryVersions;
+		uint64_t sceneVersion, builtSceneVersion, listVersion;
+		uint64_t builtChangeCount; //Renderable::getChangeCount the draw list was built with
+		bool sceneSettled;
+		glm::mat4 builtViewProjection;
 		std::vector<VkSemaphore> imageAvailableSemaphores;
 		std::vector<VkSemaphore> renderFinishedSemaphores;
 		std::vector<VkFence> inFlightFences;
 		std::vector<std::shared_ptr<Renderable>> renderObjects;
 		std::vector<std::unique_ptr<Buffer>> uniformBuffers;
+		std::vector<std::unique_ptr<Buffer>> objectBuffers;
+		std::vector<std::unique_ptr<Buffer>> instanceBuffers;
+		std::vector<std::unique_ptr<Buffer>> drawCommandBuffers;
 		std::vector<VkDescriptorSet> descriptorSets;
+		//one indexed indirect draw per mesh, its instances are the objects using that mesh
+		std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+		std::vector<std::pair<uint32_t, const Renderable*>> drawObjects; //draw command index -> object
+		std::vector<uint32_t> drawTextures; //texture index of every draw object, resolved before the workers read it
+		std::vector<VkPipeline> drawPipelines; //per draw command, commands are sorted by it
+		std::unordered_map<uint64_t, uint32_t> drawCommandIndices; //pipeline index << 32 | mesh id -> draw command index
+		std::unordered_map<VkPipeline, uint32_t> pipelineIndices; //pipeline -> order it was first seen in
 		std::vector<std::shared_ptr<Image>> images;
+		std::shared_ptr<Image> placeholder;
+		TextureLoader textureLoader;
+		DepthPyramid depthPyramid;
+		FrustumCuller frustumCuller;
+		CommandRecorder commandRecorder;
+		GpuProfiler gpuProfiler;
+		CpuCuller cpuCuller;
+		BoundingSpheres cullSpheres;
+		std::vector<uint32_t> visibleCandidates;
+		std::vector<const Renderable*> candidates;
+		bool cpuCulling, occlusionCulling;
+		std::unique_ptr<ShaderWatcher> shaderWatcher;
+		//compute pipelines replaced by a reload, destroyed once no frame in flight can still run them
+		struct RetiredPipeline
+		{
+			VkPipeline pipeline;
+			uint64_t retireFrame;
+		};
+		std::vector<RetiredPipeline> retiredPipelines;
 	};
 }
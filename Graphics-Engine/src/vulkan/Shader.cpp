@@ -1,16 +1,39 @@
-#include <fstream>
+#include <mutex>
+#include <unordered_map>
 #include "Shader.hpp"
+#include "../shaders/EmbeddedShaders.hpp"
 #include "../utils/assert.hpp"
 #include "../utils/Logger.hpp"
-#include "../utils/path.hpp"
 
 namespace Vk 
 {
+	namespace
+	{
+		//code from shader hot reload, shaders created from now on use it instead of the embedded one
+		std::mutex replacedMutex;
+		std::unordered_map<std::string, std::shared_ptr<const std::vector<uint32_t>>> replacedCode;
+	}
 
-	Shader::Shader(const VkDevice logicalDevice, const std::string& path, const VkShaderStageFlagBits stage)
+	//code compiled into the binary by the build, name is the file it was built to like vert.spv
+	Shader::Shader(const VkDevice logicalDevice, const std::string& name, const VkShaderStageFlagBits stage)
 		:shaderModule(VK_NULL_HANDLE), logicalDevice(logicalDevice)
 	{
-		init(path, stage);
+		if (auto replaced = findReplaced(name))
+		{
+			init(replaced->data(), replaced->size(), stage);
+			return;
+		}
+
+		size_t wordCount = 0;
+		const uint32_t* code = findEmbedded(name, wordCount);
+		init(code, wordCount, stage);
+	}
+
+	//code is only read here, it doesnt have to outlive the shader
+	Shader::Shader(const VkDevice logicalDevice, const uint32_t* code, size_t wordCount, const VkShaderStageFlagBits stage)
+		:shaderModule(VK_NULL_HANDLE), logicalDevice(logicalDevice)
+	{
+		init(code, wordCount, stage);
 	}
 
 	Shader::~Shader()
@@ -28,14 +51,17 @@ namespace Vk
 		return createInfo;
 	}
 
-	void Shader::init(const std::string& path, const VkShaderStageFlagBits stage)
+	const ShaderReflection& Shader::getReflection() const noexcept
 	{
-		auto shaderCode = loadShader(path);
+		return reflection;
+	}
 
+	void Shader::init(const uint32_t* code, size_t wordCount, const VkShaderStageFlagBits stage)
+	{
 		VkShaderModuleCreateInfo moduleInfo{};
         moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        moduleInfo.codeSize = shaderCode.size();
-        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+        moduleInfo.codeSize = wordCount * sizeof(uint32_t);
+        moduleInfo.pCode = code;
 
 		assert(vkCreateShaderModule(logicalDevice, &moduleInfo, nullptr, &shaderModule) == VK_SUCCESS, "cant create shader module");
 		
@@ -43,22 +69,52 @@ namespace Vk
 		createInfo.stage = stage;
 		createInfo.module = shaderModule;
         createInfo.pName = "main";
+
+		reflection = ShaderReflection::reflect(code, wordCount, stage);
 	}
 
-	std::vector<char> Shader::loadShader(const std::string& path) const
+	//code a shader of this name is created from right now
+	std::vector<uint32_t> Shader::getCode(const std::string& name)
 	{
-		std::string shaderFolder = getFileDir(__FILE__) + "\\..\\shaders\\";
-		std::ifstream file(shaderFolder + path, std::ios::ate | std::ios::binary);
+		if (auto replaced = findReplaced(name))
+			return *replaced;
 
-		assert(file.is_open(), "cant open shader file");
+		size_t wordCount = 0;
+		const uint32_t* code = findEmbedded(name, wordCount);
+		return std::vector<uint32_t>(code, code + wordCount);
+	}
 
-		std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+	//shaders already created keep their module, callers rebuild what uses them
+	void Shader::replaceCode(const std::string& name, std::vector<uint32_t> code)
+	{
+		auto replaced = std::make_shared<const std::vector<uint32_t>>(std::move(code));
 
-		file.seekg(0);
-		file.read(buffer.data(), buffer.size());
-		file.close();
+		std::lock_guard<std::mutex> lock(replacedMutex);
+		replacedCode[name] = std::move(replaced);
+	}
 
-		return buffer;
+	const uint32_t* Shader::findEmbedded(const std::string& name, size_t& wordCount)
+	{
+		for (const auto& shader : EmbeddedShaders::shaders)
+		{
+			if (name == shader.name)
+			{
+				wordCount = shader.wordCount;
+				return shader.words;
+			}
+		}
+
+		//every shader the engine loads has to be listed in the pre-build event
+		LOG_ERROR(name + " is not embedded, add its source to the shader build step");
+		assert(false, "cant find embedded shader");
+		return nullptr;
+	}
+
+	std::shared_ptr<const std::vector<uint32_t>> Shader::findReplaced(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(replacedMutex);
+		auto found = replacedCode.find(name);
+		return found != replacedCode.end() ? found->second : nullptr;
 	}
 
 }
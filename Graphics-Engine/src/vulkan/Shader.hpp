@@ -3,6 +3,8 @@
 #include <vulkan/vulkan.h>
 #include <string>
 #include <vector>
+#include <memory>
+#include "ShaderReflection.hpp"
 
 namespace Vk 
 {
@@ -10,7 +12,8 @@ namespace Vk
 	class Shader //module and stage dont need to be members for now
 	{
 	public:
-		explicit Shader(const VkDevice logicalDevice, const std::string& path, const VkShaderStageFlagBits stage);
+		explicit Shader(const VkDevice logicalDevice, const std::string& name, const VkShaderStageFlagBits stage);
+		explicit Shader(const VkDevice logicalDevice, const uint32_t* code, size_t wordCount, const VkShaderStageFlagBits stage);
 		~Shader();
 		
 		Shader(const Shader&) = delete;
@@ -18,14 +21,20 @@ namespace Vk
 
 		VkShaderModule getModule() const noexcept;
 		VkPipelineShaderStageCreateInfo getCreateInfo() const noexcept;
+		const ShaderReflection& getReflection() const noexcept;
+
+		static std::vector<uint32_t> getCode(const std::string& name);
+		static void replaceCode(const std::string& name, std::vector<uint32_t> code);
 
 	private:
-		void init(const std::string& path, const VkShaderStageFlagBits stage);
-		std::vector<char> loadShader(const std::string& path) const;
+		void init(const uint32_t* code, size_t wordCount, const VkShaderStageFlagBits stage);
+		static const uint32_t* findEmbedded(const std::string& name, size_t& wordCount);
+		static std::shared_ptr<const std::vector<uint32_t>> findReplaced(const std::string& name);
 
 	private:
 		VkShaderModule shaderModule;
 		const VkDevice logicalDevice;
 		VkPipelineShaderStageCreateInfo createInfo{};
+		ShaderReflection reflection;
 	};
 }
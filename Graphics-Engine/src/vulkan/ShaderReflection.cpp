@@ -0,0 +1,409 @@
+#include <algorithm>
+#include "ShaderReflection.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	namespace
+	{
+		constexpr uint32_t spirvMagic = 0x07230203;
+
+		enum Op : uint32_t
+		{
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpVariable = 59
+		};
+
+		enum Decoration : uint32_t
+		{
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBuiltIn = 11,
+			DecorationLocation = 30,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35
+		};
+
+		enum StorageClass : uint32_t
+		{
+			StorageUniformConstant = 0,
+			StorageInput = 1,
+			StorageUniform = 2,
+			StoragePushConstant = 9,
+			StorageStorageBuffer = 12
+		};
+
+		enum Dim : uint32_t
+		{
+			DimBuffer = 5,
+			DimSubpassData = 6
+		};
+
+		constexpr uint32_t noValue = UINT32_MAX;
+
+		struct Id
+		{
+			uint32_t opcode = 0;
+			std::vector<uint32_t> operands; //everything after the result id
+			uint32_t set = noValue, binding = noValue, location = noValue;
+			uint32_t arrayStride = 0;
+			bool builtIn = false, bufferBlock = false;
+			std::vector<uint32_t> memberOffsets, memberMatrixStrides;
+		};
+
+		class Parser
+		{
+		public:
+			Parser(const uint32_t* code, size_t wordCount)
+			{
+				assert(wordCount > 5 && code[0] == spirvMagic, "cant reflect shader, not spir-v");
+				//every id is the result of an instruction, so a valid bound never exceeds the word count
+				assert(code[3] <= wordCount, "cant reflect shader, id bound too large");
+
+				ids.resize(code[3]);
+				for (size_t word = 5; word < wordCount;)
+				{
+					const uint32_t opcode = code[word] & 0xFFFF;
+					const uint32_t count = code[word] >> 16;
+					assert(count != 0 && word + count <= wordCount, "cant reflect shader, broken instruction");
+
+					parse(opcode, code + word + 1, count - 1);
+					word += count;
+				}
+			}
+
+			const std::vector<Id>& getIds() const noexcept
+			{
+				return ids;
+			}
+
+			//ids and operands read from the code are checked before indexing, broken code asserts instead of reading past the end
+			const Id& get(uint32_t id) const
+			{
+				assert(id < ids.size(), "cant reflect shader, id out of bounds");
+				return ids[id];
+			}
+
+			static uint32_t getOperand(const Id& id, size_t index)
+			{
+				assert(index < id.operands.size(), "cant reflect shader, missing operand");
+				return id.operands[index];
+			}
+
+			//pointer and array wrappers removed
+			uint32_t getBaseType(uint32_t type) const
+			{
+				while (get(type).opcode == OpTypeArray || get(type).opcode == OpTypeRuntimeArray)
+					type = getOperand(get(type), 0);
+				return type;
+			}
+
+			uint32_t getArraySize(uint32_t type) const
+			{
+				uint32_t size = 1;
+				for (; get(type).opcode == OpTypeArray || get(type).opcode == OpTypeRuntimeArray; type = getOperand(get(type), 0))
+				{
+					if (get(type).opcode == OpTypeRuntimeArray)
+						return 0;
+					size *= getOperand(get(getOperand(get(type), 1)), 1);
+				}
+				return size;
+			}
+
+			//bytes a value of the type takes with the offsets and strides the compiler decorated it with
+			uint32_t getTypeSize(uint32_t type, uint32_t matrixStride = 0) const
+			{
+				const Id& id = get(type);
+				switch (id.opcode)
+				{
+				case OpTypeInt:
+				case OpTypeFloat:
+					return getOperand(id, 0) / 8;
+				case OpTypeVector:
+					return getTypeSize(getOperand(id, 0)) * getOperand(id, 1);
+				case OpTypeMatrix:
+					return (matrixStride != 0 ? matrixStride : getTypeSize(getOperand(id, 0))) * getOperand(id, 1);
+				case OpTypeArray:
+					return (id.arrayStride != 0 ? id.arrayStride : getTypeSize(getOperand(id, 0))) * getOperand(get(getOperand(id, 1)), 1);
+				case OpTypeStruct:
+				{
+					uint32_t size = 0;
+					for (size_t member = 0; member < id.operands.size(); ++member)
+					{
+						const uint32_t offset = member < id.memberOffsets.size() ? id.memberOffsets[member] : 0;
+						const uint32_t stride = member < id.memberMatrixStrides.size() ? id.memberMatrixStrides[member] : 0;
+						size = std::max(size, offset + getTypeSize(id.operands[member], stride));
+					}
+					return size;
+				}
+				default:
+					return 0;
+				}
+			}
+
+		private:
+			void parse(uint32_t opcode, const uint32_t* operands, uint32_t count)
+			{
+				switch (opcode)
+				{
+				case OpDecorate:
+					assert(count >= 2, "cant reflect shader, broken decoration");
+					decorate(getDefined(operands[0]), operands[1], count > 2 ? operands[2] : 0);
+					break;
+				case OpMemberDecorate:
+					assert(count >= 3, "cant reflect shader, broken decoration");
+					decorateMember(getDefined(operands[0]), operands[1], operands[2], count > 3 ? operands[3] : 0);
+					break;
+				case OpTypeInt:
+				case OpTypeFloat:
+				case OpTypeVector:
+				case OpTypeMatrix:
+				case OpTypeImage:
+				case OpTypeSampler:
+				case OpTypeSampledImage:
+				case OpTypeArray:
+				case OpTypeRuntimeArray:
+				case OpTypeStruct:
+				case OpTypePointer:
+					assert(count >= 1, "cant reflect shader, broken type");
+					define(operands[0], opcode, operands + 1, count - 1);
+					break;
+				case OpConstant:
+				case OpVariable:
+					//result id comes second here, the result type is kept as the first operand
+					assert(count >= 2, "cant reflect shader, broken instruction");
+					define(operands[1], opcode, operands, count);
+					ids[operands[1]].operands.erase(ids[operands[1]].operands.begin() + 1);
+					break;
+				default:
+					break;
+				}
+			}
+
+			void define(uint32_t result, uint32_t opcode, const uint32_t* operands, uint32_t count)
+			{
+				Id& id = getDefined(result);
+				id.opcode = opcode;
+				id.operands.assign(operands, operands + count);
+			}
+
+			Id& getDefined(uint32_t id)
+			{
+				assert(id < ids.size(), "cant reflect shader, id out of bounds");
+				return ids[id];
+			}
+
+			void decorate(Id& id, uint32_t decoration, uint32_t value)
+			{
+				if (decoration == DecorationDescriptorSet)
+					id.set = value;
+				else if (decoration == DecorationBinding)
+					id.binding = value;
+				else if (decoration == DecorationLocation)
+					id.location = value;
+				else if (decoration == DecorationArrayStride)
+					id.arrayStride = value;
+				else if (decoration == DecorationBuiltIn)
+					id.builtIn = true;
+				else if (decoration == DecorationBufferBlock)
+					id.bufferBlock = true;
+			}
+
+			void decorateMember(Id& id, uint32_t member, uint32_t decoration, uint32_t value)
+			{
+				//a struct cant have more members than there are ids
+				assert(member < ids.size(), "cant reflect shader, member out of bounds");
+				if (decoration == DecorationOffset)
+				{
+					id.memberOffsets.resize(std::max<size_t>(id.memberOffsets.size(), member + 1), 0);
+					id.memberOffsets[member] = value;
+				}
+				else if (decoration == DecorationMatrixStride)
+				{
+					id.memberMatrixStrides.resize(std::max<size_t>(id.memberMatrixStrides.size(), member + 1), 0);
+					id.memberMatrixStrides[member] = value;
+				}
+			}
+
+		private:
+			std::vector<Id> ids;
+		};
+
+		VkDescriptorType getDescriptorType(const Parser& parser, uint32_t storageClass, uint32_t type)
+		{
+			const Id& id = parser.get(type);
+			if (storageClass == StorageStorageBuffer || (storageClass == StorageUniform && id.bufferBlock))
+				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			if (storageClass == StorageUniform)
+				return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+			if (id.opcode == OpTypeSampledImage)
+				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			if (id.opcode == OpTypeSampler)
+				return VK_DESCRIPTOR_TYPE_SAMPLER;
+
+			assert(id.opcode == OpTypeImage, "cant reflect shader, unknown resource type");
+			const uint32_t dim = Parser::getOperand(id, 1);
+			const bool storage = Parser::getOperand(id, 5) == 2;
+			if (dim == DimBuffer)
+				return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			if (dim == DimSubpassData)
+				return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+
+		//32 bit scalars and vectors, the only vertex inputs the engine has
+		VkFormat getInputFormat(const Parser& parser, uint32_t type)
+		{
+			uint32_t components = 1;
+			if (parser.get(type).opcode == OpTypeVector)
+			{
+				components = Parser::getOperand(parser.get(type), 1);
+				type = Parser::getOperand(parser.get(type), 0);
+			}
+
+			const Id& scalar = parser.get(type);
+			if (scalar.operands.empty() || scalar.operands[0] != 32)
+				return VK_FORMAT_UNDEFINED;
+
+			static constexpr VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+			static constexpr VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+			static constexpr VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+			if (components < 1 || components > 4)
+				return VK_FORMAT_UNDEFINED;
+			if (scalar.opcode == OpTypeFloat)
+				return floatFormats[components - 1];
+			return Parser::getOperand(scalar, 1) ? intFormats[components - 1] : uintFormats[components - 1];
+		}
+	}
+
+	ShaderReflection ShaderReflection::reflect(const uint32_t* code, size_t wordCount, VkShaderStageFlagBits stage)
+	{
+		Parser parser(code, wordCount);
+		const auto& ids = parser.getIds();
+
+		ShaderReflection reflection;
+		for (const Id& variable : ids)
+		{
+			if (variable.opcode != OpVariable)
+				continue;
+
+			const uint32_t storageClass = Parser::getOperand(variable, 1);
+			const uint32_t pointeeType = Parser::getOperand(parser.get(Parser::getOperand(variable, 0)), 1);
+
+			if (storageClass == StoragePushConstant)
+			{
+				reflection.pushConstants.push_back({ static_cast<VkShaderStageFlags>(stage), 0, parser.getTypeSize(pointeeType) });
+			}
+			else if (storageClass == StorageInput)
+			{
+				if (stage == VK_SHADER_STAGE_VERTEX_BIT && !variable.builtIn && variable.location != noValue)
+					reflection.inputs.push_back({ variable.location, getInputFormat(parser, pointeeType) });
+			}
+			else if ((storageClass == StorageUniformConstant || storageClass == StorageUniform || storageClass == StorageStorageBuffer) &&
+				variable.binding != noValue)
+			{
+				ShaderBinding binding;
+				binding.set = variable.set == noValue ? 0 : variable.set;
+				binding.binding = variable.binding;
+				binding.type = getDescriptorType(parser, storageClass, parser.getBaseType(pointeeType));
+				binding.count = parser.getArraySize(pointeeType);
+				binding.stages = stage;
+				reflection.bindings.push_back(binding);
+			}
+		}
+
+		std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		std::sort(reflection.inputs.begin(), reflection.inputs.end(), [](const ShaderInput& a, const ShaderInput& b) {
+			return a.location < b.location;
+		});
+
+		return reflection;
+	}
+
+	//combines the stages of a program, resources used by several stages are visible to all of them
+	void ShaderReflection::merge(const ShaderReflection& other)
+	{
+		for (const ShaderBinding& binding : other.bindings)
+		{
+			auto found = std::find_if(bindings.begin(), bindings.end(), [&binding](const ShaderBinding& existing) {
+				return existing.set == binding.set && existing.binding == binding.binding;
+			});
+
+			if (found == bindings.end())
+			{
+				bindings.push_back(binding);
+				continue;
+			}
+
+			assert(found->type == binding.type && found->count == binding.count, "cant merge shader stages, binding declared differently");
+			found->stages |= binding.stages;
+		}
+
+		std::sort(bindings.begin(), bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+
+		for (const VkPushConstantRange& range : other.pushConstants)
+		{
+			auto found = std::find_if(pushConstants.begin(), pushConstants.end(), [&range](const VkPushConstantRange& existing) {
+				return existing.offset == range.offset && existing.size == range.size;
+			});
+
+			if (found == pushConstants.end())
+				pushConstants.push_back(range);
+			else
+				found->stageFlags |= range.stageFlags;
+		}
+
+		if (inputs.empty())
+			inputs = other.inputs;
+	}
+
+	const ShaderBinding* ShaderReflection::findBinding(uint32_t set, uint32_t binding) const noexcept
+	{
+		for (const ShaderBinding& existing : bindings)
+		{
+			if (existing.set == set && existing.binding == binding)
+				return &existing;
+		}
+		return nullptr;
+	}
+
+	//same bindings, push constants and vertex inputs, code with the same interface fits the layouts made for the other one
+	bool ShaderReflection::hasSameInterface(const ShaderReflection& other) const noexcept
+	{
+		auto sameBinding = [](const ShaderBinding& a, const ShaderBinding& b) {
+			return a.set == b.set && a.binding == b.binding && a.type == b.type && a.count == b.count && a.stages == b.stages;
+		};
+		auto sameRange = [](const VkPushConstantRange& a, const VkPushConstantRange& b) {
+			return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+		};
+		auto sameInput = [](const ShaderInput& a, const ShaderInput& b) {
+			return a.location == b.location && a.format == b.format;
+		};
+
+		return std::equal(bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(), sameBinding) &&
+			std::equal(pushConstants.begin(), pushConstants.end(), other.pushConstants.begin(), other.pushConstants.end(), sameRange) &&
+			std::equal(inputs.begin(), inputs.end(), other.inputs.begin(), other.inputs.end(), sameInput);
+	}
+}
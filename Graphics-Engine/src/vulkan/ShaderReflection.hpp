@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+namespace Vk
+{
+	struct ShaderBinding
+	{
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uint32_t count = 1; //zero for runtime arrays, their size is up to the layout
+		VkShaderStageFlags stages = 0;
+	};
+
+	struct ShaderInput
+	{
+		uint32_t location = 0;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+	};
+
+	//resources a spir-v module uses, read straight from its decorations and types
+	//only what layouts and vertex input need is looked at, everything else in the module is skipped
+	struct ShaderReflection
+	{
+		std::vector<ShaderBinding> bindings; //sorted by set and binding
+		std::vector<VkPushConstantRange> pushConstants;
+		std::vector<ShaderInput> inputs; //vertex stage only, sorted by location
+
+		static ShaderReflection reflect(const uint32_t* code, size_t wordCount, VkShaderStageFlagBits stage);
+		void merge(const ShaderReflection& other);
+		const ShaderBinding* findBinding(uint32_t set, uint32_t binding) const noexcept;
+		bool hasSameInterface(const ShaderReflection& other) const noexcept;
+	};
+}
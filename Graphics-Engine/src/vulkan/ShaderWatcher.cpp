@@ -0,0 +1,164 @@
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include "ShaderWatcher.hpp"
+#include "Shader.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/assert.hpp"
+
+namespace Vk
+{
+	ShaderWatcher::ShaderWatcher(const std::string& sourceDirectory, std::chrono::milliseconds pollInterval)
+		:sourceDirectory(sourceDirectory), pollInterval(pollInterval), compilerPath(getToolPath("glslc")), optimizerPath(getToolPath("spirv-opt")), stopping(false)
+	{
+		thread = std::thread(&ShaderWatcher::run, this);
+		LOG_INFO("watching shaders in " + sourceDirectory);
+	}
+
+	ShaderWatcher::~ShaderWatcher()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_one();
+		thread.join();
+	}
+
+	//source is relative to the watched directory, name is the embedded shader it replaces
+	void ShaderWatcher::watch(const std::string& source, const std::string& name, VkShaderStageFlagBits stage)
+	{
+		WatchedShader shader{ sourceDirectory / source, name, stage, {} };
+
+		std::error_code error;
+		shader.writeTime = std::filesystem::last_write_time(shader.source, error);
+		if (error)
+			LOG_WARNING("cant find shader source " + shader.source.string());
+
+		std::lock_guard<std::mutex> lock(mutex);
+		shaders.push_back(std::move(shader));
+	}
+
+	//names of shaders with new code since the last call
+	std::vector<std::string> ShaderWatcher::takeChanged()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<std::string> names;
+		names.swap(changed);
+		return names;
+	}
+
+	void ShaderWatcher::run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!condition.wait_for(lock, pollInterval, [this]() { return stopping; }))
+		{
+			lock.unlock();
+			poll();
+			lock.lock();
+		}
+	}
+
+	//compiles outside the lock, the render thread never waits for the compiler
+	void ShaderWatcher::poll()
+	{
+		std::vector<WatchedShader> modified;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (WatchedShader& shader : shaders)
+			{
+				std::error_code error;
+				auto writeTime = std::filesystem::last_write_time(shader.source, error);
+				if (error || writeTime == shader.writeTime)
+					continue;
+
+				shader.writeTime = writeTime;
+				modified.push_back(shader);
+			}
+		}
+
+		for (const WatchedShader& shader : modified)
+		{
+			if (!compile(shader))
+				continue;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (std::find(changed.begin(), changed.end(), shader.name) == changed.end())
+				changed.push_back(shader.name);
+		}
+	}
+
+	//a shader that doesnt compile or declares different resources only gets a warning, the running one stays
+	//optimized like compile.bat does, the interface is compared against embedded code that went through the same steps
+	bool ShaderWatcher::compile(const WatchedShader& shader)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		const std::filesystem::path output = std::filesystem::temp_directory_path() / (shader.name + ".reload");
+		const std::string quotedOutput = "\"" + output.string() + "\"";
+		if (!runTool(compilerPath, "\"" + shader.source.string() + "\" -o " + quotedOutput) ||
+			!runTool(optimizerPath, "-O " + quotedOutput + " -o " + quotedOutput))
+		{
+			LOG_WARNING("cant compile " + shader.source.filename().string() + ", keeping the running version");
+			return false;
+		}
+
+		try
+		{
+			std::ifstream file(output, std::ios::ate | std::ios::binary);
+			assert(file.is_open(), "cant open recompiled shader");
+
+			size_t size = static_cast<size_t>(file.tellg());
+			assert(size % sizeof(uint32_t) == 0, "recompiled shader is not spir-v");
+
+			std::vector<uint32_t> code(size / sizeof(uint32_t));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(size));
+			assert(file.good(), "cant read recompiled shader");
+
+			const std::vector<uint32_t> running = Shader::getCode(shader.name);
+			ShaderReflection reflection = ShaderReflection::reflect(code.data(), code.size(), shader.stage);
+			if (!reflection.hasSameInterface(ShaderReflection::reflect(running.data(), running.size(), shader.stage)))
+			{
+				LOG_WARNING(shader.source.filename().string() + " changed its resources or inputs, restart to use it");
+				return false;
+			}
+
+			Shader::replaceCode(shader.name, std::move(code));
+		}
+		catch (const std::exception& error)
+		{
+			LOG_WARNING(std::string("cant reload shader: ") + error.what());
+			return false;
+		}
+
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		LOG_INFO(shader.source.filename().string() + " recompiled in " + STR(milliseconds) + " ms");
+		return true;
+	}
+
+	bool ShaderWatcher::runTool(const std::string& tool, const std::string& arguments)
+	{
+		std::string command = "\"" + tool + "\" " + arguments;
+#ifdef _WIN32
+		command = "\"" + command + "\""; //cmd drops the outer quotes
+#endif
+		return std::system(command.c_str()) == 0;
+	}
+
+	//tool of the installed sdk like the build uses, without one it has to be on the path
+	std::string ShaderWatcher::getToolPath(const std::string& tool)
+	{
+		const char* sdk = std::getenv("VULKAN_SDK");
+		if (sdk == nullptr)
+			return tool;
+
+#ifdef _WIN32
+		const std::filesystem::path path = std::filesystem::path(sdk) / "Bin" / (tool + ".exe");
+#else
+		const std::filesystem::path path = std::filesystem::path(sdk) / "bin" / tool;
+#endif
+		std::error_code error;
+		return std::filesystem::exists(path, error) ? path.string() : tool;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <chrono>
+#include "ShaderReflection.hpp"
+
+namespace Vk
+{
+	//watches glsl sources during development and recompiles them on its own thread when they are saved
+	//new code replaces the embedded one through Shader::replaceCode, the render thread picks up the names with takeChanged
+	//and rebuilds the pipelines using them, shaders whose resources changed are rejected since the layouts stay as they are
+	class ShaderWatcher
+	{
+	public:
+		explicit ShaderWatcher(const std::string& sourceDirectory, std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+		~ShaderWatcher();
+
+		ShaderWatcher(const ShaderWatcher&) = delete;
+		ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+		void watch(const std::string& source, const std::string& name, VkShaderStageFlagBits stage);
+		std::vector<std::string> takeChanged();
+
+	private:
+		struct WatchedShader
+		{
+			std::filesystem::path source;
+			std::string name; //what the engine asks Shader for, vert.spv
+			VkShaderStageFlagBits stage;
+			std::filesystem::file_time_type writeTime;
+		};
+
+		void run();
+		void poll();
+		bool compile(const WatchedShader& shader);
+		static bool runTool(const std::string& tool, const std::string& arguments);
+		static std::string getToolPath(const std::string& tool);
+
+	private:
+		const std::filesystem::path sourceDirectory;
+		const std::chrono::milliseconds pollInterval;
+		const std::string compilerPath;
+		const std::string optimizerPath;
+		std::vector<WatchedShader> shaders;
+		std::vector<std::string> changed;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping;
+		std::thread thread;
+	};
+}
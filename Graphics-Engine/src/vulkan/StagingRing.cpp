@@ -0,0 +1,185 @@
+#include "StagingRing.hpp"
+#include "Buffer.hpp"
+#include "SwapChain.hpp"
+#include "../utils/assert.hpp"
+#include "../utils/Logger.hpp"
+
+namespace Vk
+{
+	StagingRing::StagingRing(const Device& device, VkDeviceSize capacity)
+		:device(device), capacity(capacity), data(nullptr), head(0), tail(0), usedSize(0), openSize(0),
+		nextSegment(1), completedSegment(0), frameBytes(0), frameStalls(0)
+	{
+		buffer = std::make_unique<Buffer>(device, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		data = static_cast<char*>(buffer->getMappedData());
+	}
+
+	StagingRing::~StagingRing()
+	{
+		for (auto& segment : segments)
+		{
+			vkWaitForFences(device.getLogicalDevice(), 1, &segment.fence, VK_TRUE, NO_TIMEOUT);
+			vkDestroyFence(device.getLogicalDevice(), segment.fence, nullptr);
+		}
+
+		for (auto fence : freeFences)
+			vkDestroyFence(device.getLogicalDevice(), fence, nullptr);
+	}
+
+	StagingRing::Region StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		assert(size <= capacity, "upload is bigger than the staging ring");
+
+		auto region = tryAllocate(size, alignment);
+		if (region.has_value())
+			return region.value();
+
+		frameStalls++;
+		stats.totalStalls++;
+
+		while (!region.has_value())
+		{
+			assert(!segments.empty(), "staging ring is full of unsubmitted uploads");
+
+			vkWaitForFences(device.getLogicalDevice(), 1, &segments.front().fence, VK_TRUE, NO_TIMEOUT);
+			releaseOldestSegment();
+			region = tryAllocate(size, alignment);
+		}
+
+		return region.value();
+	}
+
+	std::optional<StagingRing::Region> StagingRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (usedSize == 0)
+			head = tail = 0;
+
+		VkDeviceSize alignedHead = (head + alignment - 1) / alignment * alignment;
+		VkDeviceSize offset, consumed;
+
+		if (usedSize == 0 || head > tail)
+		{
+			if (alignedHead + size <= capacity)
+			{
+				offset = alignedHead;
+				consumed = alignedHead - head + size;
+			}
+			else if (size <= tail)
+			{
+				//the end of the ring is skipped and counted as used until this segment is released
+				offset = 0;
+				consumed = capacity - head + size;
+			}
+			else
+			{
+				return std::nullopt;
+			}
+		}
+		else if (alignedHead + size <= tail)
+		{
+			offset = alignedHead;
+			consumed = alignedHead - head + size;
+		}
+		else
+		{
+			return std::nullopt;
+		}
+
+		head = offset + size;
+		usedSize += consumed;
+		openSize += consumed;
+		frameBytes += size;
+		stats.totalBytes += size;
+
+		return Region{ buffer->getBuffer(), offset, size, data + offset };
+	}
+
+	std::pair<uint64_t, VkFence> StagingRing::closeSegment()
+	{
+		VkFence fence;
+		if (freeFences.empty())
+		{
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			assert(vkCreateFence(device.getLogicalDevice(), &fenceInfo, nullptr, &fence) == VK_SUCCESS, "cant create fence");
+		}
+		else
+		{
+			fence = freeFences.back();
+			freeFences.pop_back();
+		}
+
+		Segment segment{ nextSegment++, head, openSize, fence };
+		segments.push_back(segment);
+		openSize = 0;
+
+		return std::make_pair(segment.id, fence);
+	}
+
+	bool StagingRing::isComplete(uint64_t segment)
+	{
+		if (segment > completedSegment)
+			collect();
+
+		return segment <= completedSegment;
+	}
+
+	void StagingRing::wait(uint64_t segment)
+	{
+		assert(segment < nextSegment, "cant wait for a segment that wasnt submitted");
+
+		while (completedSegment < segment)
+		{
+			vkWaitForFences(device.getLogicalDevice(), 1, &segments.front().fence, VK_TRUE, NO_TIMEOUT);
+			releaseOldestSegment();
+		}
+	}
+
+	void StagingRing::collect()
+	{
+		while (!segments.empty() && vkGetFenceStatus(device.getLogicalDevice(), segments.front().fence) == VK_SUCCESS)
+			releaseOldestSegment();
+	}
+
+	void StagingRing::endFrame()
+	{
+		collect();
+
+		if (frameStalls != 0)
+			LOG_WARNING("staging ring was full " + STR(frameStalls) + " times this frame, " + STR(frameBytes) + " bytes streamed");
+
+		stats.bytesLastFrame = frameBytes;
+		stats.stallsLastFrame = frameStalls;
+		frameBytes = 0;
+		frameStalls = 0;
+	}
+
+	uint64_t StagingRing::getOpenSegment() const noexcept
+	{
+		return nextSegment;
+	}
+
+	VkDeviceSize StagingRing::getCapacity() const noexcept
+	{
+		return capacity;
+	}
+
+	const StagingStats& StagingRing::getStats() const noexcept
+	{
+		return stats;
+	}
+
+	void StagingRing::releaseOldestSegment()
+	{
+		Segment& segment = segments.front();
+
+		tail = segment.end;
+		usedSize -= segment.usedSize;
+		completedSegment = segment.id;
+
+		vkResetFences(device.getLogicalDevice(), 1, &segment.fence);
+		freeFences.push_back(segment.fence);
+		segments.pop_front();
+	}
+}
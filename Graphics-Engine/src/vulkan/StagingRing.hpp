@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace Vk
+{
+	class Device;
+	class Buffer;
+
+	struct StagingStats
+	{
+		VkDeviceSize bytesLastFrame = 0;
+		uint32_t stallsLastFrame = 0;
+		VkDeviceSize totalBytes = 0;
+		uint32_t totalStalls = 0;
+	};
+
+	//persistently mapped upload memory, data is written at the head and reclaimed at the tail
+	//once the fence of the segment it was submitted with has signaled
+	class StagingRing
+	{
+	public:
+		struct Region
+		{
+			VkBuffer buffer;
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			void* data;
+		};
+
+		explicit StagingRing(const Device& device, VkDeviceSize capacity = 64 * 1024 * 1024);
+		~StagingRing();
+
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+
+		Region allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		std::optional<Region> tryAllocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+		std::pair<uint64_t, VkFence> closeSegment();
+		bool isComplete(uint64_t segment);
+		void wait(uint64_t segment);
+		void collect();
+		void endFrame();
+		uint64_t getOpenSegment() const noexcept;
+		VkDeviceSize getCapacity() const noexcept;
+		const StagingStats& getStats() const noexcept;
+
+	private:
+		struct Segment
+		{
+			uint64_t id;
+			VkDeviceSize end;
+			VkDeviceSize usedSize;
+			VkFence fence;
+		};
+
+		void releaseOldestSegment();
+
+	private:
+		const Device& device;
+		const VkDeviceSize capacity;
+		std::unique_ptr<Buffer> buffer;
+		char* data;
+		VkDeviceSize head, tail, usedSize, openSize;
+		std::deque<Segment> segments;
+		std::vector<VkFence> freeFences;
+		uint64_t nextSegment, completedSegment;
+		VkDeviceSize frameBytes;
+		uint32_t frameStalls;
+		StagingStats stats;
+	};
+}
@@ -151,7 +151,7 @@ namespace Vk
 			imageInfo.format = depthFormat;
 			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			imageInfo.flags = 0;
@@ -210,6 +210,17 @@ namespace Vk
 		}
 	}
 
+	//sampled after the render pass to build the depth pyramid for occlusion culling
+	const std::vector<VkImage>& SwapChain::getDepthImages() const noexcept
+	{
+		return depthImages;
+	}
+
+	const std::vector<VkImageView>& SwapChain::getDepthImageViews() const noexcept
+	{
+		return depthImageViews;
+	}
+
 	uint32_t SwapChain::getImageCount() const noexcept
 	{
 		return static_cast<uint32_t>(images.size());
@@ -336,7 +347,7 @@ namespace Vk
 		return device.getSupportedFormat(
 		  {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
 		  VK_IMAGE_TILING_OPTIMAL,
-		  VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		  VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT //the depth pyramid samples it
 		);
 	}
 }
@@ -30,6 +30,8 @@ namespace Vk
 		VkExtent2D getExtent() const;
 		VkFormat getImageFormat() const;
 		const std::vector<VkImageView>& getImageViews() const;
+		const std::vector<VkImage>& getDepthImages() const noexcept;
+		const std::vector<VkImageView>& getDepthImageViews() const noexcept;
 		VkResult acquireNextImage(VkSemaphore semaphore, uint32_t* imageIndex) const;
 		void presentImage(uint32_t imageIndex, VkSemaphore* waitSemaphores) const;
 		VkSwapchainKHR getSwapChain() const;
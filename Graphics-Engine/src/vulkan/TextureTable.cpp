@@ -0,0 +1,177 @@
+#include <algorithm>
+#include "TextureTable.hpp"
+#include "Device.hpp"
+#include "../utils/assert.hpp"
+#include "../utils/Logger.hpp"
+
+namespace Vk
+{
+	TextureTable::TextureTable(const Device& device, uint32_t maxTextures, uint32_t retireFrames)
+		:device(device), capacity(maxTextures), retireFrames(retireFrames), layout(VK_NULL_HANDLE), descriptorPool(VK_NULL_HANDLE),
+		descriptorSet(VK_NULL_HANDLE), nextIndex(fallbackIndex + 1), frame(0)
+	{
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2(device.getPhysicalDevice(), &properties);
+
+		capacity = std::min({ capacity, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+			indexingProperties.maxDescriptorSetUpdateAfterBindSamplers });
+
+		createLayout();
+		createDescriptorSet();
+	}
+
+	//called after the device is idle, nothing can sample retired textures anymore
+	TextureTable::~TextureTable()
+	{
+		for (auto& retired : retiredIndices)
+			retired.destroy();
+
+		vkDestroyDescriptorPool(device.getLogicalDevice(), descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(device.getLogicalDevice(), layout, nullptr);
+	}
+
+	uint32_t TextureTable::add(VkImageView imageView, VkSampler sampler)
+	{
+		uint32_t index;
+		if (!freeIndices.empty())
+		{
+			index = freeIndices.back();
+			freeIndices.pop_back();
+		}
+		else
+		{
+			assert(nextIndex < capacity, "texture table is full");
+			index = nextIndex++;
+		}
+
+		write(index, imageView, sampler);
+		return index;
+	}
+
+	void TextureTable::remove(uint32_t index, std::function<void()> destroy)
+	{
+		if (index == fallbackIndex)
+		{
+			destroy();
+			return;
+		}
+
+		retiredIndices.push_back({ frame, index, std::move(destroy) });
+	}
+
+	void TextureTable::setFallback(VkImageView imageView, VkSampler sampler)
+	{
+		write(fallbackIndex, imageView, sampler);
+	}
+
+	void TextureTable::endFrame()
+	{
+		++frame;
+
+		while (!retiredIndices.empty() && retiredIndices.front().frame + retireFrames <= frame)
+		{
+			retiredIndices.front().destroy();
+			freeIndices.push_back(retiredIndices.front().index);
+			retiredIndices.pop_front();
+		}
+	}
+
+	VkDescriptorSetLayout TextureTable::getLayout() const noexcept
+	{
+		return layout;
+	}
+
+	VkDescriptorSet TextureTable::getDescriptorSet() const noexcept
+	{
+		return descriptorSet;
+	}
+
+	uint32_t TextureTable::getCapacity() const noexcept
+	{
+		return capacity;
+	}
+
+	uint32_t TextureTable::getCount() const noexcept
+	{
+		return nextIndex - static_cast<uint32_t>(freeIndices.size() + retiredIndices.size());
+	}
+
+	void TextureTable::createLayout()
+	{
+		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+		samplerLayoutBinding.binding = binding;
+		samplerLayoutBinding.descriptorCount = capacity;
+		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		samplerLayoutBinding.pImmutableSamplers = nullptr;
+		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		//slots past the last texture are never written, new ones are written while older frames are still in flight
+		VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = 1;
+		bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		createInfo.pNext = &bindingFlagsInfo;
+		createInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		createInfo.bindingCount = 1;
+		createInfo.pBindings = &samplerLayoutBinding;
+
+		assert(vkCreateDescriptorSetLayout(device.getLogicalDevice(), &createInfo, nullptr, &layout) == VK_SUCCESS, "cant create descriptor layout");
+	}
+
+	void TextureTable::createDescriptorSet()
+	{
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = capacity;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = 1;
+
+		assert(vkCreateDescriptorPool(device.getLogicalDevice(), &poolInfo, nullptr, &descriptorPool) == VK_SUCCESS, "cant create descriptor pool");
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		assert(vkAllocateDescriptorSets(device.getLogicalDevice(), &allocInfo, &descriptorSet) == VK_SUCCESS, "cant allocate descriptor set");
+
+		LOG_INFO("texture table holds up to " + STR(capacity) + " textures");
+	}
+
+	void TextureTable::write(uint32_t index, VkImageView imageView, VkSampler sampler)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = sampler;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = descriptorSet;
+		descriptorWrite.dstBinding = binding;
+		descriptorWrite.dstArrayElement = index;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(device.getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+	}
+}
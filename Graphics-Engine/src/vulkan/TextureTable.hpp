@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <functional>
+
+namespace Vk
+{
+	class Device;
+
+	//one update after bind descriptor set with a sampler array every texture lives in, shaders index it by TextureTable::add
+	//index 0 is the fallback drawn for textures that are not uploaded yet
+	//removed indices are reused only after retireFrames frames so a frame still in flight never sees them change
+	//what the slot points to has to live as long, remove takes the function destroying it and calls it once the index is free
+	class TextureTable
+	{
+	public:
+		static constexpr uint32_t fallbackIndex = 0;
+		static constexpr uint32_t binding = 1;
+
+		explicit TextureTable(const Device& device, uint32_t maxTextures = 4096, uint32_t retireFrames = 3);
+		~TextureTable();
+
+		TextureTable(const TextureTable&) = delete;
+		TextureTable& operator=(const TextureTable&) = delete;
+
+		uint32_t add(VkImageView imageView, VkSampler sampler);
+		void remove(uint32_t index, std::function<void()> destroy);
+		void setFallback(VkImageView imageView, VkSampler sampler);
+		void endFrame();
+		VkDescriptorSetLayout getLayout() const noexcept;
+		VkDescriptorSet getDescriptorSet() const noexcept;
+		uint32_t getCapacity() const noexcept;
+		uint32_t getCount() const noexcept;
+
+	private:
+		struct RetiredIndex
+		{
+			uint64_t frame; //frame it was removed in
+			uint32_t index;
+			std::function<void()> destroy;
+		};
+
+		void createLayout();
+		void createDescriptorSet();
+		void write(uint32_t index, VkImageView imageView, VkSampler sampler);
+
+	private:
+		const Device& device;
+		uint32_t capacity;
+		const uint32_t retireFrames;
+		VkDescriptorSetLayout layout;
+		VkDescriptorPool descriptorPool;
+		VkDescriptorSet descriptorSet;
+		uint32_t nextIndex;
+		uint64_t frame;
+		std::vector<uint32_t> freeIndices;
+		std::deque<RetiredIndex> retiredIndices;
+	};
+}
@@ -0,0 +1,289 @@
+#include "UploadContext.hpp"
+#include "Device.hpp"
+#include "../utils/assert.hpp"
+#include "../utils/Logger.hpp"
+
+namespace Vk
+{
+	UploadContext::UploadContext(const Device& device, StagingRing& stagingRing)
+		:device(device), stagingRing(stagingRing), useTransferQueue(device.hasTransferQueue()),
+		commandPool(VK_NULL_HANDLE), acquirePool(VK_NULL_HANDLE), completedToken(0)
+	{
+		QueueFamilyIndices queueFamilyIndices = device.getQueueFamilies(device.getPhysicalDevice());
+		graphicsFamily = queueFamilyIndices.graphicsFamily.value();
+		transferFamily = useTransferQueue ? queueFamilyIndices.transferFamily.value() : graphicsFamily;
+
+		commandPool = createCommandPool(transferFamily);
+		if (useTransferQueue)
+		{
+			acquirePool = createCommandPool(graphicsFamily);
+			LOG_INFO("uploading on dedicated transfer queue family " + STR(transferFamily));
+		}
+	}
+
+	UploadContext::~UploadContext()
+	{
+		vkDeviceWaitIdle(device.getLogicalDevice());
+
+		for (auto& acquiredBatch : acquiredBatches)
+			vkDestroyFence(device.getLogicalDevice(), acquiredBatch.acquireFence, nullptr);
+		for (auto fence : freeFences)
+			vkDestroyFence(device.getLogicalDevice(), fence, nullptr);
+
+		vkDestroyCommandPool(device.getLogicalDevice(), commandPool, nullptr);
+		vkDestroyCommandPool(device.getLogicalDevice(), acquirePool, nullptr);
+	}
+
+	StagingRing::Region UploadContext::stage(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		auto region = stagingRing.tryAllocate(size, alignment);
+
+		//the open batch holds part of the ring, it has to be submitted before that space can come back
+		if (!region.has_value())
+		{
+			flush();
+			region = stagingRing.allocate(size, alignment);
+		}
+
+		memcpy(region->data, data, static_cast<size_t>(size));
+		return region.value();
+	}
+
+	VkCommandBuffer UploadContext::getCommandBuffer()
+	{
+		if (batch.commandBuffer == VK_NULL_HANDLE)
+			beginBatch();
+
+		return batch.commandBuffer;
+	}
+
+	//work that needs a graphics capable queue, it runs after everything released to graphics in the same batch
+	VkCommandBuffer UploadContext::getGraphicsCommandBuffer()
+	{
+		getCommandBuffer();
+		return useTransferQueue ? batch.acquireBuffer : batch.commandBuffer;
+	}
+
+	UploadToken UploadContext::copyBuffer(const void* data, VkDeviceSize size, VkBuffer destinationBuffer, VkDeviceSize destinationOffset)
+	{
+		auto staging = stage(data, size);
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = staging.offset;
+		copyRegion.dstOffset = destinationOffset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(getCommandBuffer(), staging.buffer, destinationBuffer, 1, &copyRegion);
+
+		if (useTransferQueue)
+		{
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.buffer = destinationBuffer;
+			barrier.offset = destinationOffset;
+			barrier.size = size;
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(batch.acquireBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 0, nullptr, 1, &barrier, 0, nullptr);
+		}
+
+		return getToken();
+	}
+
+	void UploadContext::releaseToGraphics(const VkImageMemoryBarrier& barrier, VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage)
+	{
+		if (!useTransferQueue)
+		{
+			vkCmdPipelineBarrier(getCommandBuffer(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+			return;
+		}
+
+		//the layout change is done by the release/acquire pair, both sides have to describe the same transition
+		VkImageMemoryBarrier release = barrier;
+		release.srcQueueFamilyIndex = transferFamily;
+		release.dstQueueFamilyIndex = graphicsFamily;
+		release.dstAccessMask = 0;
+		vkCmdPipelineBarrier(getCommandBuffer(), sourceStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &release);
+
+		VkImageMemoryBarrier acquire = release;
+		acquire.srcAccessMask = 0;
+		acquire.dstAccessMask = barrier.dstAccessMask;
+		vkCmdPipelineBarrier(batch.acquireBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &acquire);
+	}
+
+	UploadToken UploadContext::getToken() const noexcept
+	{
+		return stagingRing.getOpenSegment();
+	}
+
+	UploadToken UploadContext::flush()
+	{
+		if (batch.commandBuffer == VK_NULL_HANDLE)
+		{
+			collect();
+			return getToken() - 1;
+		}
+
+		//buffer copies dont carry their own barriers, make all of them visible to the frames submitted after this
+		if (!useTransferQueue)
+		{
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+		else
+		{
+			assert(vkEndCommandBuffer(batch.acquireBuffer) == VK_SUCCESS, "cant end acquire command buffer");
+		}
+
+		assert(vkEndCommandBuffer(batch.commandBuffer) == VK_SUCCESS, "cant end upload command buffer");
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		auto [token, fence] = stagingRing.closeSegment();
+		assert(vkQueueSubmit(device.getTransferQueue(), 1, &submitInfo, fence) == VK_SUCCESS, "cant submit upload command buffer");
+
+		batch.token = token;
+		pendingBatches.push_back(batch);
+		batch = Batch{};
+
+		collect();
+		return token;
+	}
+
+	bool UploadContext::isComplete(UploadToken token)
+	{
+		if (token > completedToken)
+			collect();
+
+		return token <= completedToken;
+	}
+
+	void UploadContext::wait(UploadToken token)
+	{
+		if (token >= getToken())
+		{
+			if (batch.commandBuffer == VK_NULL_HANDLE)
+				return;
+			flush();
+		}
+
+		stagingRing.wait(token);
+		collect();
+	}
+
+	void UploadContext::collect()
+	{
+		while (!pendingBatches.empty() && stagingRing.isComplete(pendingBatches.front().token))
+		{
+			Batch& completedBatch = pendingBatches.front();
+			freeBuffers.push_back(completedBatch.commandBuffer);
+
+			if (completedBatch.acquireBuffer != VK_NULL_HANDLE)
+				submitAcquire(completedBatch);
+
+			completedToken = completedBatch.token;
+			pendingBatches.pop_front();
+		}
+
+		while (!acquiredBatches.empty() && vkGetFenceStatus(device.getLogicalDevice(), acquiredBatches.front().acquireFence) == VK_SUCCESS)
+		{
+			Batch& acquiredBatch = acquiredBatches.front();
+
+			vkResetFences(device.getLogicalDevice(), 1, &acquiredBatch.acquireFence);
+			freeFences.push_back(acquiredBatch.acquireFence);
+			freeAcquireBuffers.push_back(acquiredBatch.acquireBuffer);
+			acquiredBatches.pop_front();
+		}
+	}
+
+	VkCommandPool UploadContext::createCommandPool(uint32_t queueFamily)
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+
+		VkCommandPool pool;
+		assert(vkCreateCommandPool(device.getLogicalDevice(), &poolInfo, nullptr, &pool) == VK_SUCCESS, "cant create upload command pool");
+		return pool;
+	}
+
+	VkCommandBuffer UploadContext::beginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& recycledBuffers)
+	{
+		VkCommandBuffer commandBuffer;
+		if (recycledBuffers.empty())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = pool;
+			allocInfo.commandBufferCount = 1;
+
+			assert(vkAllocateCommandBuffers(device.getLogicalDevice(), &allocInfo, &commandBuffer) == VK_SUCCESS, "cant allocate upload command buffer");
+		}
+		else
+		{
+			commandBuffer = recycledBuffers.back();
+			recycledBuffers.pop_back();
+			vkResetCommandBuffer(commandBuffer, 0);
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		assert(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS, "cant begin upload command buffer");
+		return commandBuffer;
+	}
+
+	void UploadContext::beginBatch()
+	{
+		collect();
+
+		batch.commandBuffer = beginCommandBuffer(commandPool, freeBuffers);
+		if (useTransferQueue)
+			batch.acquireBuffer = beginCommandBuffer(acquirePool, freeAcquireBuffers);
+	}
+
+	void UploadContext::submitAcquire(Batch& completedBatch)
+	{
+		if (freeFences.empty())
+		{
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			assert(vkCreateFence(device.getLogicalDevice(), &fenceInfo, nullptr, &completedBatch.acquireFence) == VK_SUCCESS, "cant create fence");
+		}
+		else
+		{
+			completedBatch.acquireFence = freeFences.back();
+			freeFences.pop_back();
+		}
+
+		//the copies already finished on the transfer queue, so there is nothing for the graphics queue to wait on
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &completedBatch.acquireBuffer;
+
+		assert(vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, completedBatch.acquireFence) == VK_SUCCESS, "cant submit acquire command buffer");
+		acquiredBatches.push_back(completedBatch);
+	}
+}
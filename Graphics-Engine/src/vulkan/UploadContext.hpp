@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <vector>
+#include "StagingRing.hpp"
+
+namespace Vk
+{
+	using UploadToken = uint64_t;
+
+	//records copies and layout barriers of many resources into one command buffer
+	//the batch is submitted on flush or when the staging ring has no room left for it
+	//with a dedicated transfer queue the copies run there and the resources are acquired by the graphics queue
+	//in a second command buffer that is only submitted once the copies are done, so rendering never waits on them
+	class UploadContext
+	{
+	public:
+		explicit UploadContext(const Device& device, StagingRing& stagingRing);
+		~UploadContext();
+
+		UploadContext(const UploadContext&) = delete;
+		UploadContext& operator=(const UploadContext&) = delete;
+
+		StagingRing::Region stage(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+		VkCommandBuffer getCommandBuffer();
+		VkCommandBuffer getGraphicsCommandBuffer();
+		UploadToken copyBuffer(const void* data, VkDeviceSize size, VkBuffer destinationBuffer, VkDeviceSize destinationOffset = 0);
+		void releaseToGraphics(const VkImageMemoryBarrier& barrier, VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage);
+		UploadToken getToken() const noexcept;
+		UploadToken flush();
+		bool isComplete(UploadToken token);
+		void wait(UploadToken token);
+		void collect();
+
+	private:
+		struct Batch
+		{
+			UploadToken token = 0;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer acquireBuffer = VK_NULL_HANDLE;
+			VkFence acquireFence = VK_NULL_HANDLE;
+		};
+
+		VkCommandPool createCommandPool(uint32_t queueFamily);
+		VkCommandBuffer beginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& recycledBuffers);
+		void beginBatch();
+		void submitAcquire(Batch& completedBatch);
+
+	private:
+		const Device& device;
+		StagingRing& stagingRing;
+		const bool useTransferQueue;
+		uint32_t graphicsFamily, transferFamily;
+		VkCommandPool commandPool, acquirePool;
+		Batch batch;
+		std::deque<Batch> pendingBatches, acquiredBatches;
+		std::vector<VkCommandBuffer> freeBuffers, freeAcquireBuffers;
+		std::vector<VkFence> freeFences;
+		UploadToken completedToken;
+	};
+}
@@ -0,0 +1,188 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <iomanip>
+#include <cctype>
+#include "../../Graphics-Engine/src/utils/Logger.hpp"
+#include "../../Graphics-Engine/src/utils/assert.hpp"
+
+struct Options
+{
+	std::string outputPath;
+	std::vector<std::string> inputPaths;
+};
+
+struct Shader
+{
+	std::string name; //file name the engine asks for, vert.spv
+	std::string identifier; //array name in the header, vert
+	std::vector<uint32_t> words;
+};
+
+constexpr uint32_t spirvMagic = 0x07230203;
+constexpr size_t wordsPerLine = 8;
+
+void printUsage()
+{
+	LOG_INFO("usage: Shader-Embedder -o output.hpp shader.spv...");
+}
+
+Options parseOptions(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-o" && hasValue)
+			options.outputPath = argv[++i];
+		else if (arg[0] != '-')
+			options.inputPaths.push_back(arg);
+		else
+			assert(false, "unknown argument");
+	}
+
+	assert(!options.outputPath.empty(), "missing output file");
+	assert(!options.inputPaths.empty(), "missing input files");
+	return options;
+}
+
+//anything that is not a letter or digit becomes an underscore, a leading digit gets one in front
+std::string getIdentifier(const std::string& name)
+{
+	std::string identifier;
+	for (char character : name)
+		identifier += std::isalnum(static_cast<unsigned char>(character)) ? character : '_';
+
+	if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0])))
+		identifier = "_" + identifier;
+
+	return identifier;
+}
+
+Shader loadShader(const std::string& path)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	assert(file.is_open(), "cant open shader file");
+
+	size_t size = static_cast<size_t>(file.tellg());
+	assert(size >= 5 * sizeof(uint32_t) && size % sizeof(uint32_t) == 0, "shader file is not spir-v");
+
+	Shader shader;
+	std::filesystem::path filePath(path);
+	shader.name = filePath.filename().string();
+	shader.identifier = getIdentifier(filePath.stem().string());
+	shader.words.resize(size / sizeof(uint32_t));
+
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(shader.words.data()), static_cast<std::streamsize>(size));
+	assert(file.good(), "cant read shader file");
+	assert(shader.words[0] == spirvMagic, "shader file is not spir-v");
+
+	return shader;
+}
+
+std::string createHeader(const std::vector<Shader>& shaders)
+{
+	std::ostringstream header;
+	header << "//generated by Shader-Embedder from the optimized spir-v, edit the glsl sources instead\n";
+	header << "#pragma once\n\n";
+	header << "#include <cstdint>\n";
+	header << "#include <cstddef>\n\n";
+	header << "namespace EmbeddedShaders\n{\n";
+	header << "\tstruct Code\n\t{\n";
+	header << "\t\tconst char* name;\n";
+	header << "\t\tconst uint32_t* words;\n";
+	header << "\t\tsize_t wordCount;\n";
+	header << "\t};\n";
+
+	header << std::hex << std::setfill('0');
+	for (const Shader& shader : shaders)
+	{
+		header << "\n\tinline constexpr uint32_t " << shader.identifier << "[] = {";
+		for (size_t i = 0; i < shader.words.size(); ++i)
+		{
+			header << (i % wordsPerLine == 0 ? "\n\t\t" : " ");
+			header << "0x" << std::setw(8) << shader.words[i] << ",";
+		}
+		header << "\n\t};\n";
+	}
+	header << std::dec;
+
+	header << "\n\tinline constexpr Code shaders[] = {\n";
+	for (const Shader& shader : shaders)
+		header << "\t\t{ \"" << shader.name << "\", " << shader.identifier << ", sizeof(" << shader.identifier << ") / sizeof(uint32_t) },\n";
+	header << "\t};\n";
+	header << "}\n";
+
+	return header.str();
+}
+
+//an unchanged header is left alone, rewriting it would recompile everything including it on every build
+bool writeIfChanged(const std::string& path, const std::string& content)
+{
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (file.is_open())
+		{
+			std::ostringstream existing;
+			existing << file.rdbuf();
+			if (existing.str() == content)
+				return false;
+		}
+	}
+
+	const std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		assert(file.is_open(), "cant create header file");
+
+		file.write(content.data(), static_cast<std::streamsize>(content.size()));
+		file.flush();
+		assert(file.good(), "cant write header file");
+	}
+
+	std::filesystem::rename(temporaryPath, path);
+	return true;
+}
+
+void run(const Options& options)
+{
+	std::vector<Shader> shaders;
+	size_t byteCount = 0;
+	for (const std::string& path : options.inputPaths)
+	{
+		shaders.push_back(loadShader(path));
+		byteCount += shaders.back().words.size() * sizeof(uint32_t);
+	}
+
+	if (writeIfChanged(options.outputPath, createHeader(shaders)))
+		LOG_INFO(options.outputPath + " written, " + STR(shaders.size()) + " shaders " + STR(byteCount) + " bytes");
+	else
+		LOG_INFO(options.outputPath + " is up to date");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	try
+	{
+		run(parseOptions(argc, argv));
+	}
+	catch (const std::exception& exception)
+	{
+		LOG_CRITICAL(exception.what());
+		printUsage();
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+#include "../../Graphics-Engine/src/utils/Logger.hpp"
+#include "../../Graphics-Engine/src/utils/assert.hpp"
+#include "../../Graphics-Engine/src/textures/BlockCompression.hpp"
+#include "../../Graphics-Engine/src/textures/MipChain.hpp"
+#include "../../Graphics-Engine/src/textures/TextureFile.hpp"
+
+struct Options
+{
+	std::string input;
+	std::string output;
+	std::optional<BlockFormat> format = BlockFormat::BC7;
+	uint32_t threadCount = 0;
+	bool srgb = true;
+	bool mipmaps = true;
+};
+
+void printUsage()
+{
+	LOG_INFO("usage: Texture-Compressor <image> [-o out.tex] [-f bc1|bc3|bc7|rgba8] [-j threads] [--linear] [--no-mips]");
+}
+
+Options parseOptions(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-o" && hasValue)
+			options.output = argv[++i];
+		else if (arg == "-j" && hasValue)
+			options.threadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "-f" && hasValue)
+		{
+			std::string format = argv[++i];
+			if (format == "bc1")
+				options.format = BlockFormat::BC1;
+			else if (format == "bc3")
+				options.format = BlockFormat::BC3;
+			else if (format == "bc7")
+				options.format = BlockFormat::BC7;
+			else if (format == "rgba8")
+				options.format = std::nullopt;
+			else
+				assert(false, "unknown block format");
+		}
+		else if (arg == "--linear")
+			options.srgb = false;
+		else if (arg == "--no-mips")
+			options.mipmaps = false;
+		else if (options.input.empty())
+			options.input = arg;
+		else
+			assert(false, "unknown argument");
+	}
+
+	assert(!options.input.empty(), "no input image");
+
+	if (options.output.empty())
+		options.output = options.input.substr(0, options.input.find_last_of('.')) + ".tex";
+
+	return options;
+}
+
+//psnr of the rgb channels, what the encoder is tuned for
+double getPsnr(const uint8_t* original, const uint8_t* decoded, size_t pixelCount)
+{
+	double error = 0.0;
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		for (size_t c = 0; c < 3; ++c)
+		{
+			double diff = static_cast<double>(original[i * 4 + c]) - decoded[i * 4 + c];
+			error += diff * diff;
+		}
+	}
+
+	double mse = error / (pixelCount * 3.0);
+	return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+void run(const Options& options)
+{
+	int32_t width, height, channels;
+	std::unique_ptr<stbi_uc, void(*)(void*)> pixels(stbi_load(options.input.c_str(), &width, &height, &channels, STBI_rgb_alpha), stbi_image_free);
+	assert(pixels != nullptr, "cant load image");
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	MipChain chain = MipChain::build(pixels.get(), width, height, options.srgb, options.mipmaps ? 0 : 1);
+
+	std::vector<std::vector<uint8_t>> levelData;
+	for (const auto& level : chain.levels)
+	{
+		const uint8_t* levelPixels = chain.data.data() + level.offset;
+		if (options.format)
+			levelData.push_back(BlockCompression::compress(*options.format, levelPixels, level.width, level.height, options.threadCount));
+		else
+			levelData.emplace_back(levelPixels, levelPixels + level.size);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	TextureFile::save(options.output, options.format, options.srgb, width, height, levelData);
+
+	size_t compressedSize = 0;
+	for (const auto& level : levelData)
+		compressedSize += level.size();
+
+	auto decoded = options.format ? BlockCompression::decompress(*options.format, levelData[0].data(), width, height) : levelData[0];
+
+	LOG_INFO(options.output + ": " + STR(width) + "x" + STR(height) + ", " + STR(chain.levels.size()) + " levels");
+	LOG_INFO("compressed in " + STR(milliseconds) + " ms, ratio " + STR(static_cast<double>(chain.data.size()) / compressedSize));
+	LOG_INFO("level 0 psnr " + STR(getPsnr(pixels.get(), decoded.data(), static_cast<size_t>(width) * height)) + " dB");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	try
+	{
+		run(parseOptions(argc, argv));
+	}
+	catch (const std::exception& exception)
+	{
+		LOG_CRITICAL(exception.what());
+		printUsage();
+		return 1;
+	}
+
+	return 0;
+}